@@ -0,0 +1,8 @@
+# Row-major vs Z-order tiled pixel layout (8-connected contours) on the
+# resolution ladder of the ICDAR test images (see ../dataset-icdar/scale_down_images.sh).
+mkdir -p runtime-zorder-resolutions
+for res in 120x68 240x135 480x270 960x540; do
+  ../programs/build/contour_bench -a padded8,zorder8 -o "runtime-zorder-resolutions/runtime_$res.csv" ../dataset-icdar/$res/test50/*
+  sleep 5
+done
+../programs/build/contour_bench -a padded8,zorder8 -o "runtime-zorder-resolutions/runtime_1920x1080.csv" ../dataset-icdar/1920x1080/test/*
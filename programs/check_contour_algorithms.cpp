@@ -1,14 +1,40 @@
+#include "contour/incremental.hpp"
 #include "contour/nonincremental.hpp"
+#include "contour/smalltolarge.hpp"
+#include "contour/delta.hpp"
+#include "contour/padded.hpp"
+#include "contour/ncount.hpp"
+#include "contour/parallel.hpp"
+#include "contour/chaincode.hpp"
+#include "contour/archive.hpp"
+#include "contour/perfcounters.hpp"
+#include "contour/nodepool.hpp"
+#include "contour/flatset.hpp"
+#include "contour/bitmap.hpp"
+#include "contour/sortedvector.hpp"
+#include "contour/query.hpp"
+#include "contour/counts.hpp"
+#include "contour/contourindex.hpp"
+#include "contour/update.hpp"
+#include "contour/filter.hpp"
+#include "contour/flattree.hpp"
+#include "contour/zorder.hpp"
 
 #include <morphotree/core/box.hpp>
 #include <morphotree/attributes/countorExtraction.hpp>
 
 #include <morphotree/adjacency/adjacency4c.hpp>
 #include <morphotree/adjacency/adjacency8c.hpp>
+#include <morphotree/attributes/areaComputer.hpp>
 
 #include <morphotree/core/io.hpp>
 
+#include <cstdint>
+#include <cstdio>
 #include <iostream>
+#include <limits>
+#include <set>
+#include <string>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -27,10 +53,145 @@ bool isEqual(const morphotree::Box &domain, const std::vector<bool> &a,
   return true;
 }
 
+template<class ContourSet>
+std::vector<bool> contourSetToImage(const morphotree::Box &domain, 
+  const ContourSet &contour)
+{
+  std::vector<bool> bimg(domain.numberOfPoints(), false);
+  for (morphotree::uint32 pidx : contour)
+    bimg[pidx] = true;
+
+  return bimg;
+}
+
+// Compare the contours computed by "algorithm" against the non-incremental 
+// ones and report every node that differs.
+template<class ContourSet>
+bool checkContours(const std::string &algorithm, const morphotree::Box &domain,
+  const morphotree::MorphologicalTree<morphotree::uint8> &tree,
+  const std::vector<std::vector<bool>> &nonIncrContours, 
+  const std::vector<ContourSet> &contours)
+{
+  using NodePtr = typename morphotree::MorphologicalTree<morphotree::uint8>::NodePtr;
+
+  bool hasDifferentNode = false;
+  tree.tranverse([&](NodePtr node) {
+    if (!isEqual(domain, nonIncrContours[node->id()], 
+      contourSetToImage(domain, contours[node->id()]))) {
+      std::cout << "[" << algorithm << "] Contours for node " << node->id() 
+                << " are NOT equal!\n";
+      hasDifferentNode = true;
+    }
+  });
+
+  return hasDifferentNode;
+}
+
+// Check that every chain-code loop of a node is a closed walk along its crack
+// edges with the node on the right-hand side (outer boundaries clockwise,
+// holes counter-clockwise), whose spans follow each other and which goes
+// through the pinches as the tree connectivity says ("diagonal" for an
+// 8-connected tree), and that the loops of a node cover each of its crack
+// edges exactly once.
+bool checkChainLoops(const morphotree::Box &domain,
+  const morphotree::MorphologicalTree<morphotree::uint8> &tree,
+  const ChainContours &chains, bool diagonal)
+{
+  using morphotree::uint32;
+  using morphotree::int32;
+  using NodePtr = typename morphotree::MorphologicalTree<morphotree::uint8>::NodePtr;
+
+  // step to the pixel across direction d, along direction d, and corner of
+  // the pixel where its edge of direction d starts
+  static const int32 NX[] = { 0, 1, 0, -1 };
+  static const int32 NY[] = { -1, 0, 1, 0 };
+  static const int32 MX[] = { 1, 0, -1, 0 };
+  static const int32 MY[] = { 0, 1, 0, -1 };
+  static const int32 CX[] = { 0, 1, 1, 0 };
+  static const int32 CY[] = { 0, 0, 1, 1 };
+
+  const int32 width = domain.width();
+  const int32 height = domain.height();
+  std::vector<uint32> seen(4 * domain.numberOfPoints(), 0);   // node id + 1 per walked edge
+
+  bool hasWrongNode = false;
+  tree.tranverse([&](NodePtr node) {
+    const std::vector<uint32> pixels = node->reconstruct();
+    const std::vector<bool> inside = node->reconstruct(domain);
+    auto in = [&inside, width, height](int32 x, int32 y) {
+      return 0 <= x && x < width && 0 <= y && y < height && inside[y*width + x];
+    };
+
+    uint32 crackEdges = 0;
+    for (uint32 pidx : pixels) {
+      for (int d = 0; d < 4; d++) {
+        if (!in(pidx % width + NX[d], pidx / width + NY[d]))
+          crackEdges++;
+      }
+    }
+
+    // direction of the edge after the edge (x, y, d): left turn, straight
+    // on or right turn
+    auto turn = [&in, diagonal](int32 x, int32 y, int d) {
+      const int32 rx = x + MX[d], ry = y + MY[d];
+      const bool aheadRight = in(rx, ry);
+      if (in(rx + NX[d], ry + NY[d]) && (aheadRight || diagonal))
+        return (d + 3) % 4;
+      return aheadRight ? d : (d + 1) % 4;
+    };
+
+    bool ok = true;
+    uint32 walkedEdges = 0;
+    for (uint32 i = 0; ok && i < chains.numberOfLoops(node->id()); i++) {
+      const uint32 id = chains.loopId(node->id(), i);
+      const ChainContours::Loop &l = chains.loop(id);
+      const uint32 spidx = l.start / 4;
+      const int sd = l.start % 4;
+      const int32 sx = spidx % width + CX[sd], sy = spidx / width + CY[sd];
+      ok = l.spans.begin < l.spans.end;
+
+      int32 vx = sx, vy = sy;
+      int expected = sd;
+      for (uint32 k = 0; ok && k < chains.numberOfSpans(id); k++) {
+        const ChainContours::Span &span = chains.span(chains.spanId(id, k));
+        const uint32 pidx = span.start / 4;
+        const int d0 = span.start % 4;
+        ok = span.codes.begin < span.codes.end && chains.code(span.codes.begin) == d0
+          && vx == static_cast<int32>(pidx % width) + CX[d0] 
+          && vy == static_cast<int32>(pidx / width) + CY[d0];
+
+        for (uint32 c = span.codes.begin; ok && c < span.codes.end; c++) {
+          const int d = chains.code(c);
+          const int32 x = vx - CX[d], y = vy - CY[d];
+          ok = d == expected && in(x, y) && !in(x + NX[d], y + NY[d]) 
+            && seen[4*(y*width + x) + d] != node->id() + 1;
+          if (ok) {
+            seen[4*(y*width + x) + d] = node->id() + 1;
+            expected = turn(x, y, d);
+          }
+          vx += MX[d]; vy += MY[d];
+          walkedEdges++;
+        }
+      }
+
+      ok = ok && vx == sx && vy == sy && expected == sd;
+    }
+
+    if (!ok || walkedEdges != crackEdges) {
+      std::cout << "[chain code loops] Loops for node " << node->id() 
+                << " are NOT closed crack-edge loops!\n";
+      hasWrongNode = true;
+    }
+  });
+
+  return hasWrongNode;
+}
+
 int main(int argc, char *argv[]) 
 {
   using morphotree::uint8;
   using morphotree::uint32;
+  using morphotree::int32;
   using morphotree::Adjacency;
   using morphotree::InfAdjacency4C;
   using morphotree::InfAdjacency8C;
@@ -165,6 +326,340 @@ int main(int argc, char *argv[])
     // }
   });
 
+  // ==========================================================
+  // SMALL-TO-LARGE MERGING (ALL CONTOURS REQUESTED)
+  // ==========================================================
+  std::vector<bool> requested(tree.numberOfNodes(), true);
+  hasDifferentNode |= checkContours("small-to-large hashmap", domain, tree, nonIncrContours,
+    extractCountorsSmallToLarge<std::unordered_set<uint32>>(domain, f, contourAdj, tree, requested));
+  hasDifferentNode |= checkContours("small-to-large red-black tree", domain, tree, nonIncrContours,
+    extractCountorsSmallToLarge<std::set<uint32>>(domain, f, contourAdj, tree, requested));
+
+  // ==========================================================
+  // DELTA-ENCODED CONTOURS (MATERIALIZED PER NODE)
+  // ==========================================================
+  DeltaContours delta = extractDeltaContours(domain, f, contourAdj, tree);
+  std::vector<std::unordered_set<uint32>> deltaContours(tree.numberOfNodes());
+  tree.tranverse([&delta, &deltaContours](NodePtr node) {
+    deltaContours[node->id()] = delta.materialize<uint8>(node);
+  });
+  hasDifferentNode |= checkContours("delta", domain, tree, nonIncrContours, deltaContours);
+
+  // ==========================================================
+  // PADDED-IMAGE KERNELS
+  // ==========================================================
+  std::vector<std::vector<bool>> nonIncrPaddedContours(tree.numberOfNodes());
+  tree.tranverse([&domain, &nonIncrPaddedContours, inContourAdj](NodePtr node){
+    std::vector<bool> nimg = node->reconstruct(domain);
+    if (inContourAdj == '8')
+      nonIncrPaddedContours[node->id()] = 
+        computeContourNonIncrementalPadded<InfAdjacency8C>(domain, nimg);
+    else 
+      nonIncrPaddedContours[node->id()] = 
+        computeContourNonIncrementalPadded<InfAdjacency4C>(domain, nimg);
+  });
+  tree.tranverse([&](NodePtr node) {
+    if (!isEqual(domain, nonIncrContours[node->id()], nonIncrPaddedContours[node->id()])) {
+      std::cout << "[non-incremental padded] Contours for node " << node->id() 
+                << " are NOT equal!\n";
+      hasDifferentNode = true;
+    }
+  });
+
+  if (inContourAdj == '8')
+    hasDifferentNode |= checkContours("padded", domain, tree, nonIncrContours, 
+      extractCountorsPadded<InfAdjacency8C, std::unordered_set<uint32>>(domain, f, tree));
+  else
+    hasDifferentNode |= checkContours("padded", domain, tree, nonIncrContours, 
+      extractCountorsPadded<InfAdjacency4C, std::unordered_set<uint32>>(domain, f, tree));
+
+  // ==========================================================
+  // Z-ORDER TILED LAYOUT (contours translated back to row-major
+  // indices)
+  // ==========================================================
+  {
+    TiledLayout layout{domain};
+    std::vector<std::unordered_set<uint32>> tiledContours;
+    if (inContourAdj == '8')
+      tiledContours = extractCountorsTiled<InfAdjacency8C, std::unordered_set<uint32>>(domain, f, 
+        tree, layout);
+    else
+      tiledContours = extractCountorsTiled<InfAdjacency4C, std::unordered_set<uint32>>(domain, f, 
+        tree, layout);
+
+    hasDifferentNode |= checkContours("z-order tiles", domain, tree, nonIncrContours, 
+      contoursToRowMajor(layout, tiledContours));
+  }
+
+  // ==========================================================
+  // PRECOMPUTED LOWER-NEIGHBOUR COUNTS
+  // ==========================================================
+  if (inContourAdj == '8')
+    hasDifferentNode |= checkContours("precomputed ncount", domain, tree, nonIncrContours, 
+      extractCountorsPrecomputed<InfAdjacency8C, std::unordered_set<uint32>>(domain, f, tree));
+  else
+    hasDifferentNode |= checkContours("precomputed ncount", domain, tree, nonIncrContours, 
+      extractCountorsPrecomputed<InfAdjacency4C, std::unordered_set<uint32>>(domain, f, tree));
+
+  // ==========================================================
+  // RED-BLACK TREE SETS IN A NODE POOL
+  // ==========================================================
+  {
+    NodePool nodePool;
+    hasDifferentNode |= checkContours("pooled red-black tree", domain, tree, nonIncrContours, 
+      extractCountorsIncremental<PooledSet>(domain, f, contourAdj, tree, 
+        PoolAllocator<uint32>(nodePool)));
+  }
+
+  // ==========================================================
+  // OPEN-ADDRESSING FLAT HASH SETS
+  // ==========================================================
+  hasDifferentNode |= checkContours("flat set", domain, tree, nonIncrContours, 
+    extractCountorsFlatSet(domain, f, contourAdj, tree));
+
+  // ==========================================================
+  // ROW BITMAP CONTOURS
+  // ==========================================================
+  hasDifferentNode |= checkContours("bitmap", domain, tree, nonIncrContours, 
+    extractCountorsBitmap(domain, f, contourAdj, tree));
+
+  // ==========================================================
+  // SORTED VECTORS (K-WAY MERGE)
+  // ==========================================================
+  hasDifferentNode |= checkContours("sorted vector", domain, tree, nonIncrContours, 
+    extractCountorsSortedVector(domain, f, contourAdj, tree));
+
+  // ==========================================================
+  // PHASE-SPLIT EXTRACTION (HARDWARE COUNTERS)
+  // ==========================================================
+  {
+    PhaseCounters counters;
+    hasDifferentNode |= checkContours("profiled", domain, tree, nonIncrContours, 
+      extractCountorsIncrementalProfiled<std::unordered_set<uint32>>(domain, f, contourAdj, 
+        tree, counters));
+  }
+
+  // ==========================================================
+  // SUBTREE-PARALLEL EXTRACTION (contour adjacency must be 
+  // contained in the tree adjacency)
+  // ==========================================================
+  if (!(inTreeAdj == '4' && inContourAdj == '8')) {
+    WorkStealingPool pool(4);
+    hasDifferentNode |= checkContours("parallel", domain, tree, nonIncrContours,
+      extractCountorsParallel<std::unordered_set<uint32>>(domain, f, contourAdj, tree, pool, 
+        std::numeric_limits<uint32>::max(), 8));
+    hasDifferentNode |= checkContours("parallel wide nodes", domain, tree, nonIncrContours,
+      extractCountorsParallel<std::unordered_set<uint32>>(domain, f, contourAdj, tree, pool, 2, 8));
+  }
+
+  // ==========================================================
+  // NODE-SUBSET AND LEVEL-BAND QUERIES (contour adjacency must
+  // be contained in the tree adjacency)
+  // ==========================================================
+  if (!(inTreeAdj == '4' && inContourAdj == '8')) {
+    std::vector<uint32> allIds(tree.numberOfNodes());
+    for (uint32 id = 0; id < tree.numberOfNodes(); id++)
+      allIds[id] = id;
+    hasDifferentNode |= checkContours("node subset", domain, tree, nonIncrContours,
+      extractCountorsOfNodes<std::unordered_set<uint32>>(domain, f, contourAdj, tree, allIds));
+
+    std::vector<uint32> bandIds = nodesInLevelBand<uint8>(tree, 100, 110);
+    std::vector<std::unordered_set<uint32>> bandContours = 
+      extractCountorsOfNodes<std::unordered_set<uint32>>(domain, f, contourAdj, tree, bandIds);
+    for (uint32 i = 0; i < bandIds.size(); i++) {
+      if (!isEqual(domain, nonIncrContours[bandIds[i]], contourSetToImage(domain, bandContours[i]))) {
+        std::cout << "[level band] Contours for node " << bandIds[i] << " are NOT equal!\n";
+        hasDifferentNode = true;
+      }
+    }
+  }
+
+  // ==========================================================
+  // IMPLICIT CONTOUR INDEX (contour adjacency must be contained
+  // in the tree adjacency)
+  // ==========================================================
+  if (!(inTreeAdj == '4' && inContourAdj == '8')) {
+    ContourIndex<uint8> index(domain, f, contourAdj, tree);
+    std::vector<std::vector<uint32>> indexContours(tree.numberOfNodes());
+    for (uint32 id = 0; id < tree.numberOfNodes(); id++)
+      indexContours[id] = index.contour(id);
+    hasDifferentNode |= checkContours("contour index", domain, tree, nonIncrContours, 
+      indexContours);
+
+    // pixels of the node, and pixels of the parent outside the node
+    tree.tranverse([&](NodePtr node) {
+      bool correct = true;
+      for (uint32 pidx : node->reconstruct())
+        correct &= index.contains(node->id(), pidx) == nonIncrContours[node->id()][pidx];
+      if (node->parent() != nullptr) {
+        for (uint32 pidx : node->parent()->cnps())
+          correct &= !index.contains(node->id(), pidx);
+      }
+
+      if (!correct) {
+        std::cout << "[contour index] Membership for node " << node->id() << " is NOT correct!\n";
+        hasDifferentNode = true;
+      }
+    });
+  }
+
+  // ==========================================================
+  // UPDATE FROM A PREVIOUS IMAGE (the image with a rectangle
+  // darkened; contour adjacency must be contained in the tree
+  // adjacency)
+  // ==========================================================
+  if (!(inTreeAdj == '4' && inContourAdj == '8')) {
+    Box dirty = Box::fromCorners({static_cast<int32>(domain.width()/4), static_cast<int32>(domain.height()/4)},
+      {static_cast<int32>(domain.width()/2), static_cast<int32>(domain.height()/2)});
+    std::vector<uint8> previousf = f;
+    for (uint32 pidx = 0; pidx < domain.numberOfPoints(); pidx++) {
+      if (dirty.contains(domain.indexToPoint(pidx)))
+        previousf[pidx] /= 2;
+    }
+
+    MTree previousTree = buildMaxTree(previousf, treeAdj);
+    std::vector<std::unordered_set<uint32>> previousContours = 
+      extractCountorsIncremental<std::unordered_set<uint32>>(domain, previousf, contourAdj, 
+        previousTree);
+    hasDifferentNode |= checkContours("update", domain, tree, nonIncrContours, 
+      updateContours(domain, f, contourAdj, tree, previousTree, previousContours, dirty));
+  }
+
+  // ==========================================================
+  // AREA FILTER (contours of the filtered tree taken from the
+  // ones of the unfiltered tree)
+  // ==========================================================
+  {
+    MTree filteredTree = buildMaxTree(f, treeAdj);
+    std::vector<std::unordered_set<uint32>> unfilteredContours = 
+      extractCountorsIncremental<std::unordered_set<uint32>>(domain, f, contourAdj, filteredTree);
+    std::vector<uint32> area = 
+      std::make_unique<morphotree::AreaComputer<uint8>>()->computeAttribute(filteredTree);
+    std::vector<std::unordered_set<uint32>> filteredContours = idirectFilterContours<std::unordered_set<uint32>, uint8>(
+      filteredTree, unfilteredContours, [&area](NodePtr node) { return area[node->id()] > 50; });
+
+    std::vector<std::vector<bool>> nonIncrFilteredContours(filteredTree.numberOfNodes());
+    filteredTree.tranverse([&domain, &nonIncrFilteredContours, contourAdj](NodePtr node) {
+      nonIncrFilteredContours[node->id()] = 
+        computeContourNonIncremental(contourAdj, domain, node->reconstruct(domain));
+    });
+    hasDifferentNode |= checkContours("area filter", domain, filteredTree, nonIncrFilteredContours,
+      filteredContours);
+  }
+
+  // ==========================================================
+  // CONTOUR COUNTS (the edges are the pairs of neighbours with
+  // one pixel outside the node when the contour adjacency is
+  // contained in the tree adjacency)
+  // ==========================================================
+  {
+    ContourCounts counts = computeContourCounts(domain, f, contourAdj, tree);
+    tree.tranverse([&](NodePtr node) {
+      uint32 pixels = 0;
+      std::uint64_t edges = 0;
+      std::vector<bool> nimg = node->reconstruct(domain);
+      for (uint32 pidx = 0; pidx < domain.numberOfPoints(); pidx++) {
+        pixels += nonIncrContours[node->id()][pidx] ? 1 : 0;
+        if (!nimg[pidx])
+          continue;
+
+        for (uint32 qidx : contourAdj->neighbours(pidx)) {
+          if (qidx == Box::UndefinedIndex || !nimg[qidx])
+            edges++;
+        }
+      }
+
+      if (counts.pixels[node->id()] != pixels 
+          || (!(inTreeAdj == '4' && inContourAdj == '8') && counts.edges[node->id()] != edges)) {
+        std::cout << "[counts] Counts for node " << node->id() << " are NOT equal!\n";
+        hasDifferentNode = true;
+      }
+    });
+  }
+
+  // ==========================================================
+  // FLAT TREE (post-order structure of arrays; the results are
+  // indexed by flat ids)
+  // ==========================================================
+  {
+    FlatTree<uint8> flat = flattenTree(tree);
+    std::vector<std::unordered_set<uint32>> flatContours = 
+      extractCountorsFlatTree<std::unordered_set<uint32>>(domain, f, contourAdj, flat);
+    std::vector<std::unordered_set<uint32>> contours(tree.numberOfNodes());
+    for (uint32 i = 0; i < flat.numberOfNodes(); i++)
+      contours[flat.originalId[i]] = std::move(flatContours[i]);
+    hasDifferentNode |= checkContours("flat tree", domain, tree, nonIncrContours, contours);
+
+    ContourCounts counts = computeContourCounts(domain, f, contourAdj, tree);
+    ContourCounts flatCounts = computeContourCountsFlatTree(domain, f, contourAdj, flat);
+    for (uint32 i = 0; i < flat.numberOfNodes(); i++) {
+      if (flatCounts.pixels[i] != counts.pixels[flat.originalId[i]] 
+          || flatCounts.edges[i] != counts.edges[flat.originalId[i]]) {
+        std::cout << "[flat tree counts] Counts for node " << flat.originalId[i] 
+                  << " are NOT equal!\n";
+        hasDifferentNode = true;
+      }
+    }
+  }
+
+  // ==========================================================
+  // MULTITHREADED NON-INCREMENTAL EXTRACTION
+  // ==========================================================
+  {
+    WorkStealingPool pool(4);
+    ContourArena arena = inContourAdj == '8' ?
+      extractCountorsNonIncrementalParallel<InfAdjacency8C>(domain, f, tree, pool, 4) :
+      extractCountorsNonIncrementalParallel<InfAdjacency4C>(domain, f, tree, pool, 4);
+    
+    std::vector<std::vector<uint32>> arenaContours(tree.numberOfNodes());
+    for (uint32 id = 0; id < tree.numberOfNodes(); id++)
+      arenaContours[id].assign(arena.begin(id), arena.end(id));
+    hasDifferentNode |= checkContours("non-incremental parallel", domain, tree, 
+      nonIncrContours, arenaContours);
+  }
+
+  // ==========================================================
+  // INCREMENTAL CHAIN CODES (the pixels of the crack-edge loops
+  // are the 4-connected contour, and each loop must be a closed and
+  // oriented walk along the crack edges of its node)
+  // ==========================================================
+  if (inContourAdj == '4') {
+    ChainContours chains = inTreeAdj == '8' ?
+      extractChainContours<InfAdjacency8C>(domain, f, tree) :
+      extractChainContours<InfAdjacency4C>(domain, f, tree);
+
+    std::vector<std::unordered_set<uint32>> chainContours(tree.numberOfNodes());
+    for (uint32 id = 0; id < tree.numberOfNodes(); id++) {
+      for (uint32 i = 0; i < chains.numberOfLoops(id); i++) {
+        std::vector<uint32> pixels = chains.pixels(domain, chains.loopId(id, i));
+        chainContours[id].insert(pixels.begin(), pixels.end());
+      }
+    }
+    hasDifferentNode |= checkContours("chain codes", domain, tree, nonIncrContours, 
+      chainContours);
+    hasDifferentNode |= checkChainLoops(domain, tree, chains, inTreeAdj == '8');
+  }
+
+  // ==========================================================
+  // ARCHIVE ROUND TRIP
+  // ==========================================================
+  {
+    const std::string archivePath = "check_contour_algorithms.ctra";
+    ContourArchive archive;
+    if (!writeContourArchive(archivePath, domain, tree, incrContours) || !archive.open(archivePath)) {
+      std::cout << "[archive] could not write or map " << archivePath << "\n";
+      hasDifferentNode = true;
+    }
+    else {
+      std::vector<std::vector<uint32>> archiveContours(tree.numberOfNodes());
+      for (uint32 id = 0; id < tree.numberOfNodes(); id++)
+        archiveContours[id] = archive.contour(id);
+      hasDifferentNode |= checkContours("archive", domain, tree, nonIncrContours, archiveContours);
+    }
+    archive.close();
+    std::remove(archivePath.c_str());
+  }
+
   if (hasDifferentNode) 
     std::cout << "The program found an error on incremental algorithm";
   else
@@ -0,0 +1,156 @@
+#include "contour/archive.hpp"
+
+#include <morphotree/core/box.hpp>
+#include <morphotree/attributes/countorExtraction.hpp>
+
+#include <morphotree/adjacency/adjacency4c.hpp>
+#include <morphotree/tree/ct_builder.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+struct Args
+{
+  std::string inImage;
+  std::string outArchive;
+  std::string inArchive;
+  long node = -1;
+};
+
+Args extractCommandArgs(int argc, char *argv[])
+{
+  Args args;
+
+  int i = 1;
+  while (i < argc) {
+    std::string option{ argv[i] };
+    i++;
+
+    if (i >= argc)
+      break;
+
+    if (option == "-i") {
+      args.inImage = std::string{argv[i]};
+    }
+    else if (option == "-o") {
+      args.outArchive = std::string{argv[i]};
+    }
+    else if (option == "-r") {
+      args.inArchive = std::string{argv[i]};
+    }
+    else if (option == "-n") {
+      args.node = std::atol(argv[i]);
+    }
+    i++;
+  }
+
+  return args;
+}
+
+void printHelp()
+{
+  std::cout << "Usage: ./contour_archive -i <input_image> -o <output_archive>\n"
+            << "       ./contour_archive -r <input_archive> [-n <node_id>]\n"
+            << "  -i <input_image>    Compute the contours of the max-tree of the image\n"
+            << "  -o <output_archive> Write the contours of every node into the archive\n"
+            << "  -r <input_archive>  Map the archive and read the contour of one node\n"
+            << "  -n <node_id>        Node to read (default: the root)\n"
+            << "-h, --help            Display this help message";
+}
+
+int main(int argc, char *argv[])
+{
+  using morphotree::uint8;
+  using morphotree::uint32;
+  using morphotree::Adjacency;
+  using morphotree::InfAdjacency4C;
+  using morphotree::Adjacency4C;
+  using morphotree::Box;
+  using MTree = morphotree::MorphologicalTree<uint8>;
+  using morphotree::buildMaxTree;
+  using morphotree::UI32Point;
+
+  using morphotree::extractCountors;
+
+  using std::chrono::high_resolution_clock;
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+
+  // ====================================================
+  // PROCESS COMMAND LINE ARGUMENTS
+  // ====================================================
+  for (int i = 0; i < argc; i++) {
+    std::string arg{ argv[i] };
+    if (arg == "-h" || arg == "--help") {
+      printHelp();
+      return 0;
+    }
+  }
+
+  Args args = extractCommandArgs(argc, argv);
+
+  if (!args.inImage.empty() && !args.outArchive.empty()) {
+    // ====================================================
+    // COMPUTE CONTOURS AND WRITE THE ARCHIVE
+    // ====================================================
+    int width, height, nchannels;
+    uint8 *data = stbi_load(args.inImage.c_str(), &width, &height, &nchannels, 1);
+
+    Box domain = Box::fromSize({static_cast<uint32>(width), static_cast<uint32>(height)});
+    std::vector<uint8> f = std::vector<uint8>(data, data + domain.numberOfPoints());
+
+    MTree tree = buildMaxTree(f, std::make_shared<Adjacency4C>(domain));
+    std::vector<std::unordered_set<uint32>> contours =
+      extractCountors(domain, f, std::make_shared<InfAdjacency4C>(domain), tree);
+
+    if (!writeContourArchive(args.outArchive, domain, tree, contours)) {
+      std::cerr << "Error: could not write " << args.outArchive << "\n";
+      return -1;
+    }
+
+    std::cout << "archive written: " << tree.numberOfNodes() << " nodes\n";
+  }
+  else if (!args.inArchive.empty()) {
+    // ====================================================
+    // MAP THE ARCHIVE AND READ ONE NODE
+    // ====================================================
+    auto start = high_resolution_clock::now();
+    ContourArchive archive;
+    if (!archive.open(args.inArchive)) {
+      std::cerr << "Error: " << args.inArchive << " is not a contour archive\n";
+      return -1;
+    }
+    auto end = high_resolution_clock::now();
+    std::cout << "open time elapsed (us): "
+              << duration_cast<microseconds>(end - start).count() << "\n";
+
+    uint32 id = archive.root();
+    if (args.node >= 0)
+      id = static_cast<uint32>(args.node);
+
+    if (id >= archive.numberOfNodes()) {
+      std::cerr << "Error: node " << id << " is not in the archive\n";
+      return -1;
+    }
+
+    start = high_resolution_clock::now();
+    std::vector<uint32> contour = archive.contour(id);
+    end = high_resolution_clock::now();
+    std::cout << "read time elapsed (us): "
+              << duration_cast<microseconds>(end - start).count()
+              << " (node " << id << ", level " << archive.level(id)
+              << ", " << contour.size() << " pixels)\n";
+  }
+  else {
+    std::cerr << "Error: invalid command line argument\n";
+    printHelp();
+    return -1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,569 @@
+#include "contour/incremental.hpp"
+#include "contour/nodepool.hpp"
+#include "contour/flatset.hpp"
+#include "contour/bitmap.hpp"
+#include "contour/sortedvector.hpp"
+#include "contour/counts.hpp"
+#include "contour/flattree.hpp"
+#include "contour/padded.hpp"
+#include "contour/zorder.hpp"
+#include "contour/nonincremental.hpp"
+#include "contour/perfcounters.hpp"
+#include "contour/tracer.hpp"
+
+#include <morphotree/core/box.hpp>
+#include <morphotree/attributes/countorExtraction.hpp>
+#include <morphotree/attributes/boundingboxComputer.hpp>
+
+#include <morphotree/adjacency/adjacency4c.hpp>
+#include <morphotree/adjacency/adjacency8c.hpp>
+#include <morphotree/tree/ct_builder.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+// The allocation hook (-m) is only compiled into the contour_bench_mem target,
+// so that the timed runs of contour_bench use the stock allocator.
+#if defined(CONTOUR_BENCH_MEMORY)
+#define CONTOUR_ALLOCATION_HOOK_IMPLEMENTATION
+#endif
+#include "contour/memory.hpp"
+
+namespace mt = morphotree;
+
+struct Args
+{
+  std::vector<std::string> images;
+  int repetitions = 10;
+  int warmup = 1;
+  std::string algorithms = "rb,rbpool,hm,flat,bitmap,sorted,soa,padded8,zorder8,nonincr,mt,trace";
+  std::string format = "csv";
+  std::string output;
+  bool counters = false;
+  bool memory = false;
+};
+
+Args extractCommandArgs(int argc, char *argv[])
+{
+  Args args;
+
+  int i = 1;
+  while (i < argc) {
+    std::string option{ argv[i] };
+    i++;
+
+    if (option[0] != '-') {
+      args.images.push_back(option);
+      continue;
+    }
+
+    if (option == "-e") {
+      args.counters = true;
+      continue;
+    }
+
+    if (option == "-m") {
+      args.memory = true;
+      continue;
+    }
+
+    if (i >= argc)
+      break;
+
+    if (option == "-r") {
+      args.repetitions = std::max(1, std::atoi(argv[i]));
+    }
+    else if (option == "-w") {
+      args.warmup = std::max(0, std::atoi(argv[i]));
+    }
+    else if (option == "-a") {
+      args.algorithms = std::string{argv[i]};
+    }
+    else if (option == "-f") {
+      args.format = std::string{argv[i]};
+    }
+    else if (option == "-o") {
+      args.output = std::string{argv[i]};
+    }
+    i++;
+  }
+
+  return args;
+}
+
+void printHelp()
+{
+  std::cout << "Usage: ./contour_bench [options] <input_image> [<input_image> ...]\n"
+            << "  -r <repetitions>    Number of measured repetitions (default: 10)\n"
+            << "  -w <warmup>         Number of warmup repetitions (default: 1)\n"
+            << "  -a <algorithms>     Comma-separated list of rb, rbpool, hm, flat, bitmap,\n"
+            << "                      sorted, soa, padded8, zorder8, nonincr, mt and trace\n"
+            << "                      (default: all of them)\n"
+            << "  -f csv|json         Output format (default: csv)\n"
+            << "  -o <output_file>    Output file (default: standard output)\n"
+            << "  -e                  Also collect hardware counters per phase of the rb and hm\n"
+            << "                      extractions (Linux perf_event_open)\n"
+            << "  -m                  Also record the heap allocations and the peak RSS of every\n"
+            << "                      algorithm (contour_bench_mem only)\n"
+            << "-h, --help            Display this help message";
+}
+
+// Samples of one measurement (nanoseconds) and their statistics (milliseconds).
+struct Samples
+{
+  std::vector<std::int64_t> ns;
+
+  double quantile(double q) const
+  {
+    std::vector<std::int64_t> sorted = ns;
+    std::sort(sorted.begin(), sorted.end());
+    std::size_t k = static_cast<std::size_t>(std::ceil(q * sorted.size()));
+    return sorted[k > 0 ? k - 1 : 0] / 1e6;
+  }
+
+  double median() const
+  {
+    std::vector<std::int64_t> sorted = ns;
+    std::sort(sorted.begin(), sorted.end());
+    std::size_t n = sorted.size();
+    return (n % 2 == 1 ? sorted[n/2] : (sorted[n/2 - 1] + sorted[n/2]) / 2.0) / 1e6;
+  }
+
+  double p95() const { return quantile(0.95); }
+  double min() const { return *std::min_element(ns.begin(), ns.end()) / 1e6; }
+};
+
+// Result of an algorithm. It is handed back to the caller so that it is
+// released after the timed region, as in the perf_* programs.
+using Result = std::shared_ptr<void>;
+
+template<class T>
+Result keepResult(T &&value)
+{
+  return std::make_shared<typename std::decay<T>::type>(std::forward<T>(value));
+}
+
+// Z-order layout of the current image size. It only depends on the size, so
+// it is built by the untimed "prepare" step of zorder8.
+const TiledLayout &tiledLayout(const mt::Box &domain)
+{
+  static std::unique_ptr<TiledLayout> layout;
+  static mt::uint32 width = 0, height = 0;
+  if (layout == nullptr || width != domain.width() || height != domain.height()) {
+    layout = std::make_unique<TiledLayout>(domain);
+    width = domain.width();
+    height = domain.height();
+  }
+
+  return *layout;
+}
+
+// Bounding boxes of the nodes of the tree "trace" runs on. They are an
+// attribute of the tree, computed by the untimed "prepare" step of trace as
+// perf_contour_trace computes them before its timer.
+std::vector<mt::Box> &traceBoundingBoxes()
+{
+  static std::vector<mt::Box> bb;
+  return bb;
+}
+
+template<class Function>
+std::int64_t timeNs(Function fn)
+{
+  using std::chrono::steady_clock;
+  using std::chrono::duration_cast;
+  using std::chrono::nanoseconds;
+
+  auto start = steady_clock::now();
+  fn();
+  auto end = steady_clock::now();
+
+  return duration_cast<nanoseconds>(end - start).count();
+}
+
+// One row of the output: the image columns of runtime_*.csv followed by the
+// statistics of every measurement.
+struct Row
+{
+  std::string image;
+  mt::uint32 nnodes;
+  mt::uint32 width;
+  mt::uint32 height;
+  std::vector<std::string> columns;
+  std::vector<Samples> samples;
+
+  // hardware counter totals of one extraction, per phase (with -e)
+  std::vector<std::string> counterColumns;
+  std::vector<std::uint64_t> counters;
+  bool countersAvailable = false;
+
+  // total contour size and allocations/peak memory of every algorithm (with -m)
+  std::vector<std::string> memoryColumns;
+  std::vector<std::uint64_t> memory;
+};
+
+int main(int argc, char *argv[])
+{
+  using mt::uint8;
+  using mt::uint32;
+  using mt::Adjacency;
+  using mt::InfAdjacency4C;
+  using mt::InfAdjacency8C;
+  using mt::Adjacency4C;
+  using mt::Adjacency8C;
+  using mt::Box;
+  using MTree = mt::MorphologicalTree<uint8>;
+  using mt::buildMaxTree;
+  using mt::BoundingBoxComputer;
+
+  using mt::extractCountors;
+
+  // ====================================================
+  // PROCESS COMMAND LINE ARGUMENTS
+  // ====================================================
+  for (int i = 0; i < argc; i++) {
+    std::string arg{ argv[i] };
+    if (arg == "-h" || arg == "--help") {
+      printHelp();
+      return 0;
+    }
+  }
+
+  Args args = extractCommandArgs(argc, argv);
+  if (args.images.empty()) {
+    std::cerr << "Error: invalid command line argument\n";
+    printHelp();
+    return -1;
+  }
+
+#if !defined(CONTOUR_BENCH_MEMORY)
+  if (args.memory) {
+    std::cerr << "Error: -m needs the allocation hook, use contour_bench_mem\n";
+    return -1;
+  }
+#endif
+
+  // ====================================================
+  // ALGORITHMS (columns named as in runtime_*.csv)
+  // ====================================================
+  struct Algorithm
+  {
+    std::string name;
+    std::string column;
+    bool tree8C;   // the tracer follows 8-connected regions, so it needs an 8-connected tree
+    std::function<Result(const Box&, const std::vector<uint8>&, const MTree&)> run;
+    std::function<PhaseCounters(const Box&, const std::vector<uint8>&, const MTree&)> profile = nullptr;   // -e
+    std::function<void(const Box&, const MTree&)> prepare = nullptr;   // untimed, before each run
+  };
+
+  const std::vector<Algorithm> all = {
+    { "rb", "runtime_incr_contour_rb", false,
+      [](const Box &domain, const std::vector<uint8> &f, const MTree &tree) {
+        std::vector<std::set<uint32>> contours = extractCountorsIncremental<std::set<uint32>>(
+          domain, f, std::make_shared<InfAdjacency4C>(domain), tree);
+        return keepResult(std::move(contours));
+      },
+      [](const Box &domain, const std::vector<uint8> &f, const MTree &tree) {
+        PhaseCounters counters;
+        extractCountorsIncrementalProfiled<std::set<uint32>>(
+          domain, f, std::make_shared<InfAdjacency4C>(domain), tree, counters);
+        return counters;
+      } },
+    { "rbpool", "runtime_incr_contour_rb_pool", false,
+      [](const Box &domain, const std::vector<uint8> &f, const MTree &tree) {
+        // the pool is declared first, so it is released after the contours
+        struct PooledContours
+        {
+          NodePool nodePool;
+          std::vector<PooledSet> contours;
+        };
+        std::shared_ptr<PooledContours> result = std::make_shared<PooledContours>();
+        result->contours = extractCountorsIncremental<PooledSet>(domain, f, 
+          std::make_shared<InfAdjacency4C>(domain), tree, PoolAllocator<uint32>(result->nodePool));
+        return result;
+      } },
+    { "hm", "runtime_incr_contour_hm", false,
+      [](const Box &domain, const std::vector<uint8> &f, const MTree &tree) {
+        std::vector<std::unordered_set<uint32>> contours =
+          extractCountorsIncremental<std::unordered_set<uint32>>(
+            domain, f, std::make_shared<InfAdjacency4C>(domain), tree);
+        return keepResult(std::move(contours));
+      },
+      [](const Box &domain, const std::vector<uint8> &f, const MTree &tree) {
+        PhaseCounters counters;
+        extractCountorsIncrementalProfiled<std::unordered_set<uint32>>(
+          domain, f, std::make_shared<InfAdjacency4C>(domain), tree, counters);
+        return counters;
+      } },
+    { "flat", "runtime_incr_contour_flat", false,
+      [](const Box &domain, const std::vector<uint8> &f, const MTree &tree) {
+        std::vector<FlatSet> contours = extractCountorsFlatSet(
+          domain, f, std::make_shared<InfAdjacency4C>(domain), tree);
+        return keepResult(std::move(contours));
+      } },
+    { "bitmap", "runtime_incr_contour_bitmap", false,
+      [](const Box &domain, const std::vector<uint8> &f, const MTree &tree) {
+        std::vector<BitmapContour> contours = extractCountorsBitmap(
+          domain, f, std::make_shared<InfAdjacency4C>(domain), tree);
+        return keepResult(std::move(contours));
+      } },
+    { "sorted", "runtime_incr_contour_sorted", false,
+      [](const Box &domain, const std::vector<uint8> &f, const MTree &tree) {
+        std::vector<std::vector<uint32>> contours = extractCountorsSortedVector(
+          domain, f, std::make_shared<InfAdjacency4C>(domain), tree);
+        return keepResult(std::move(contours));
+      } },
+    { "soa", "runtime_incr_contour_soa", false,
+      [](const Box &domain, const std::vector<uint8> &f, const MTree &tree) {
+        // the conversion into the flat layout is part of the cost
+        FlatTree<uint8> flat = flattenTree(tree);
+        std::vector<std::unordered_set<uint32>> contours =
+          extractCountorsFlatTree<std::unordered_set<uint32>>(
+            domain, f, std::make_shared<InfAdjacency4C>(domain), flat);
+        return keepResult(std::move(contours));
+      } },
+    { "padded8", "runtime_incr_contour_padded8", false,
+      [](const Box &domain, const std::vector<uint8> &f, const MTree &tree) {
+        std::vector<std::unordered_set<uint32>> contours =
+          extractCountorsPadded<InfAdjacency8C, std::unordered_set<uint32>>(domain, f, tree);
+        return keepResult(std::move(contours));
+      } },
+    { "zorder8", "runtime_incr_contour_zorder8", false,
+      [](const Box &domain, const std::vector<uint8> &f, const MTree &tree) {
+        // the contours are translated back to row-major indices, as any
+        // caller of the row-major API needs them
+        const TiledLayout &layout = tiledLayout(domain);
+        std::vector<std::unordered_set<uint32>> contours = contoursToRowMajor(layout,
+          extractCountorsTiled<InfAdjacency8C, std::unordered_set<uint32>>(domain, f, tree, layout));
+        return keepResult(std::move(contours));
+      },
+      nullptr,
+      [](const Box &domain, const MTree &) { tiledLayout(domain); } },
+    { "nonincr", "runtime_non_incr_contour", false,
+      [](const Box &domain, const std::vector<uint8> &f, const MTree &tree) {
+        std::vector<std::unordered_set<uint32>> contours = extractCountorsNonIncremental(
+          domain, f, std::make_shared<InfAdjacency4C>(domain), tree);
+        return keepResult(std::move(contours));
+      } },
+    { "mt", "runtime_incr_contour_mt", false,
+      [](const Box &domain, const std::vector<uint8> &f, const MTree &tree) {
+        std::vector<std::unordered_set<uint32>> contours = extractCountors(
+          domain, f, std::make_shared<InfAdjacency4C>(domain), tree);
+        return keepResult(std::move(contours));
+      } },
+    { "trace", "runtime_contour_trace", true,
+      [](const Box &domain, const std::vector<uint8> &f, const MTree &tree) {
+        std::vector<TracedContour> contours = traceContours(domain, f, tree, 
+          traceBoundingBoxes());
+        return keepResult(std::move(contours));
+      },
+      nullptr,
+      [](const Box &domain, const MTree &tree) {
+        traceBoundingBoxes() =
+          std::make_unique<BoundingBoxComputer<uint8>>(domain)->computeAttribute(tree);
+      } }
+  };
+
+  std::vector<const Algorithm*> algorithms;
+  for (const Algorithm &a : all) {
+    if (("," + args.algorithms + ",").find("," + a.name + ",") != std::string::npos)
+      algorithms.push_back(&a);
+  }
+
+  // ====================================================
+  // RUN
+  // ====================================================
+  std::vector<Row> rows;
+  for (const std::string &image : args.images) {
+    Row row;
+    row.image = image.substr(image.find_last_of('/') + 1);
+    for (const Algorithm *a : algorithms)
+      row.columns.push_back(a->column);
+    row.columns.push_back("runtime_io");
+    row.columns.push_back("runtime_build");
+    row.samples.resize(row.columns.size());
+
+    Samples &io = row.samples[algorithms.size()];
+    Samples &build = row.samples[algorithms.size() + 1];
+
+    for (int rep = 0; rep < args.warmup + args.repetitions; rep++) {
+      const bool measured = rep >= args.warmup;
+
+      int width = 0, height = 0, nchannels;
+      std::vector<uint8> f;
+      std::int64_t t = timeNs([&]() {
+        uint8 *data = stbi_load(image.c_str(), &width, &height, &nchannels, 1);
+        if (data != nullptr) {
+          f.assign(data, data + width*height);
+          stbi_image_free(data);
+        }
+      });
+      if (f.empty()) {
+        std::cerr << "Error: could not read " << image << "\n";
+        return -1;
+      }
+      if (measured)
+        io.ns.push_back(t);
+
+      Box domain = Box::fromSize({static_cast<uint32>(width), static_cast<uint32>(height)});
+      std::shared_ptr<Adjacency> adj = std::make_shared<Adjacency4C>(domain);
+
+      std::unique_ptr<MTree> tree;
+      t = timeNs([&]() { tree = std::make_unique<MTree>(buildMaxTree(f, adj)); });
+      if (measured)
+        build.ns.push_back(t);
+
+      std::unique_ptr<MTree> tree8C;
+      for (std::size_t k = 0; k < algorithms.size(); k++) {
+        if (algorithms[k]->tree8C && tree8C == nullptr)
+          tree8C = std::make_unique<MTree>(buildMaxTree(f, std::make_shared<Adjacency8C>(domain)));
+
+        const MTree &algorithmTree = algorithms[k]->tree8C ? *tree8C : *tree;
+        if (algorithms[k]->prepare)
+          algorithms[k]->prepare(domain, algorithmTree);
+
+        Result result;
+        t = timeNs([&]() { result = algorithms[k]->run(domain, f, algorithmTree); });
+        result.reset();
+        if (measured)
+          row.samples[k].ns.push_back(t);
+
+        // counters are read in a separate (untimed) run after the last repetition
+        if (args.counters && algorithms[k]->profile && rep + 1 == args.warmup + args.repetitions) {
+          PhaseCounters counters = algorithms[k]->profile(domain, f, algorithmTree);
+          row.countersAvailable = counters.available;
+
+          std::string prefix = "counters" + algorithms[k]->column.substr(std::string{"runtime"}.size());
+          for (int phase = 0; phase < PhaseCounters::NumberOfPhases; phase++) {
+            for (int c = 0; c < PerfCounters::NumberOfCounters; c++) {
+              row.counterColumns.push_back(prefix + "_" + PhaseCounters::name(phase) + "_"
+                + PerfCounters::name(c));
+              row.counters.push_back(counters.values[phase][c]);
+            }
+          }
+        }
+
+        // allocations are counted in a separate (untimed) run as well, so the
+        // hook does not slow down the measured ones
+        if (args.memory && rep + 1 == args.warmup + args.repetitions) {
+          resetPeakRSS();
+          startAllocationCounting();
+          algorithms[k]->run(domain, f, algorithmTree);
+          AllocationStats stats = stopAllocationCounting();
+
+          std::string prefix = "memory" + algorithms[k]->column.substr(std::string{"runtime"}.size());
+          row.memoryColumns.insert(row.memoryColumns.end(), { prefix + "_allocations",
+            prefix + "_bytes", prefix + "_peak_bytes", prefix + "_peak_rss" });
+          row.memory.insert(row.memory.end(),
+            { stats.allocations, stats.bytes, stats.peakBytes, peakRSS() });
+        }
+      }
+
+      row.nnodes = tree->numberOfNodes();
+      row.width = width;
+      row.height = height;
+
+      // sum of the contour sizes (as in mtree_data) to relate the memory to
+      if (args.memory && rep + 1 == args.warmup + args.repetitions) {
+        std::uint64_t sumContour = 0;
+        for (uint32 size : computeContourCounts(domain, f, 
+            std::make_shared<InfAdjacency4C>(domain), *tree).pixels)
+          sumContour += size;
+        row.memoryColumns.insert(row.memoryColumns.begin(), "sum_contour");
+        row.memory.insert(row.memory.begin(), sumContour);
+      }
+    }
+
+    if (args.counters && !row.countersAvailable)
+      std::cerr << row.image << ": hardware counters are not available\n";
+    std::cerr << row.image << ": done\n";
+    rows.push_back(row);
+  }
+
+  // ====================================================
+  // OUTPUT (times in milliseconds)
+  // ====================================================
+  std::ofstream file;
+  if (!args.output.empty())
+    file.open(args.output);
+  std::ostream &out = args.output.empty() ? std::cout : file;
+  out << std::fixed << std::setprecision(6);
+
+  if (args.format == "json") {
+    out << "[\n";
+    for (std::size_t r = 0; r < rows.size(); r++) {
+      const Row &row = rows[r];
+      out << "  {\"image\": \"" << row.image << "\", \"nnodes\": " << row.nnodes
+          << ", \"width\": " << row.width << ", \"height\": " << row.height
+          << ", \"npixels\": " << row.width * row.height
+          << ", \"repetitions\": " << args.repetitions;
+      for (std::size_t k = 0; k < row.columns.size(); k++) {
+        out << ", \"" << row.columns[k] << "\": " << row.samples[k].median()
+            << ", \"" << row.columns[k] << "_p95\": " << row.samples[k].p95()
+            << ", \"" << row.columns[k] << "_min\": " << row.samples[k].min();
+      }
+      for (std::size_t k = 0; k < row.counterColumns.size(); k++) {
+        out << ", \"" << row.counterColumns[k] << "\": ";
+        if (row.countersAvailable)
+          out << row.counters[k];
+        else
+          out << "null";
+      }
+      for (std::size_t k = 0; k < row.memoryColumns.size(); k++)
+        out << ", \"" << row.memoryColumns[k] << "\": " << row.memory[k];
+      out << "}" << (r + 1 < rows.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+  }
+  else {
+    // same leading columns (and ";" separator with an index column) as runtime_*.csv
+    out << ";image;nnodes;width;height;npixels";
+    if (!rows.empty()) {
+      for (const std::string &c : rows[0].columns)
+        out << ";" << c;
+      for (const std::string &c : rows[0].columns)
+        out << ";" << c << "_p95;" << c << "_min";
+      for (const std::string &c : rows[0].counterColumns)
+        out << ";" << c;
+      for (const std::string &c : rows[0].memoryColumns)
+        out << ";" << c;
+    }
+    out << "\n";
+
+    for (std::size_t r = 0; r < rows.size(); r++) {
+      const Row &row = rows[r];
+      out << r << ";" << row.image << ";" << row.nnodes << ";" << row.width << ";"
+          << row.height << ";" << row.width * row.height;
+      for (const Samples &s : row.samples)
+        out << ";" << s.median();
+      for (const Samples &s : row.samples)
+        out << ";" << s.p95() << ";" << s.min();
+      for (std::uint64_t v : row.counters) {
+        out << ";";
+        if (row.countersAvailable)
+          out << v;
+      }
+      for (std::uint64_t v : row.memory)
+        out << ";" << v;
+      out << "\n";
+    }
+  }
+
+  return 0;
+}
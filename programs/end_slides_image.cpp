@@ -1,4 +1,5 @@
 #include "contour/nonincremental.hpp"
+#include "contour/query.hpp"
 
 #include <morphotree/core/box.hpp>
 #include <morphotree/attributes/countorExtraction.hpp>
@@ -35,7 +36,6 @@ int main(int argc, char *argv[])
   using morphotree::I32Point;
   using morphotree::AreaComputer;
 
-  using morphotree::extractCountors;
   using morphotree::reconstructContourImage;
 
    // =================================================
@@ -76,12 +76,12 @@ int main(int argc, char *argv[])
   std::vector<uint32> area = 
     std::make_unique<AreaComputer<uint8>>()->computeAttribute(tree);
   tree.idirectFilter([&area](NodePtr node) { return area[node->id()] > 6100;} );
-  std::vector<std::unordered_set<uint32>> contours = 
-    extractCountors(domain, f, std::make_shared<InfAdjacency4C>(domain), tree);
 
   NodePtr node = tree.smallComponent(domain.pointToIndex({226, 341}));
 
-  const std::unordered_set<uint32> &c = contours[node->id()];
+  std::vector<std::unordered_set<uint32>> contours = extractCountorsOfNodes<std::unordered_set<uint32>>(
+    domain, f, std::make_shared<InfAdjacency4C>(domain), tree, {node->id()});
+  const std::unordered_set<uint32> &c = contours[0];
   for (const uint32 pidx : c) {
     uint32 cpidx = pidx * 3;           // (coloured) for 3 channels
     
@@ -0,0 +1,299 @@
+#pragma once
+
+#include <morphotree/core/box.hpp>
+#include <morphotree/core/alias.hpp>
+#include <morphotree/tree/mtree.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Binary archive of the per-node contours of a component tree. Layout (host
+// byte order):
+//
+//   Header                                 (32 bytes)
+//   uint64 offsets[numberOfNodes + 1]      byte offset of each node in "data"
+//   ArchiveNode nodes[numberOfNodes]       parent, level and contour size
+//   uint8 data[]                           contour pixels of every node
+//
+// The pixels of a contour are sorted and stored as LEB128 varints of the
+// difference to the previous pixel (the first one to 0). Offsets are in CSR
+// form, so the contour of node "id" is data[offsets[id] .. offsets[id+1]).
+struct ArchiveHeader
+{
+  char magic[4];
+  morphotree::uint32 version;
+  morphotree::uint32 width;
+  morphotree::uint32 height;
+  morphotree::uint32 numberOfNodes;
+  morphotree::uint32 root;
+  std::uint64_t dataSize;
+};
+
+struct ArchiveNode
+{
+  morphotree::uint32 parent;   // ArchiveNoParent for the root
+  morphotree::int32 level;
+  morphotree::uint32 size;     // number of contour pixels
+};
+
+static const char ArchiveMagic[4] = {'C', 'T', 'R', 'A'};
+static const morphotree::uint32 ArchiveVersion = 2;
+static const morphotree::uint32 ArchiveNoParent = 0xFFFFFFFF;
+
+// Write the contours of every node of "tree" into "path". Returns false if
+// the file could not be written.
+template<class ContourSet, class ValueType>
+bool writeContourArchive(const std::string &path,
+  const morphotree::Box &domain,
+  const morphotree::MorphologicalTree<ValueType> &tree,
+  const std::vector<ContourSet> &contours);
+
+// Read-only view of an archive. The file is mapped into memory and a node
+// contour is decoded on request, without reading the other nodes.
+class ContourArchive
+{
+public:
+  using uint32 = morphotree::uint32;
+  using int32 = morphotree::int32;
+
+  ContourArchive();
+  ~ContourArchive();
+
+  ContourArchive(const ContourArchive &) = delete;
+  ContourArchive &operator=(const ContourArchive &) = delete;
+
+  // Map "path". Returns false if the file cannot be mapped or is not an
+  // archive: bad header, section sizes not matching the file, root id out of
+  // range or offsets not going from 0 to the size of "data". Only the header
+  // is checked, in constant time: the range of a node is checked when it is
+  // decoded.
+  bool open(const std::string &path);
+  void close();
+
+  uint32 width() const { return header()->width; }
+  uint32 height() const { return header()->height; }
+  uint32 numberOfNodes() const { return header()->numberOfNodes; }
+  uint32 root() const { return header()->root; }
+
+  // As stored: the parent of a node of a corrupt archive may be out of range,
+  // so it is checked against numberOfNodes() before it is used as an id.
+  uint32 parent(uint32 id) const { return nodes()[id].parent; }
+  int32 level(uint32 id) const { return nodes()[id].level; }
+  uint32 contourSize(uint32 id) const { return nodes()[id].size; }
+
+  // Sorted pixel indices of the contour of node "id".
+  std::vector<uint32> contour(uint32 id) const;
+
+  // Decoding stops at the end of the node range, also in the middle of a
+  // truncated varint. Nothing is decoded if the range of the node does not lie
+  // inside "data".
+  template<class Function>
+  void forEachPixel(uint32 id, Function fn) const;
+
+private:
+  const ArchiveHeader *header() const;
+  const ArchiveNode *nodes() const;
+  std::uint64_t offset(uint32 id) const;
+  bool validRange(uint32 id) const;
+  const morphotree::uint8 *data() const;
+
+private:
+  const morphotree::uint8 *base_;
+  std::size_t length_;
+};
+
+// =================== [IMPLEMENTATION] ==========================
+inline void appendVarint(std::vector<morphotree::uint8> &out, morphotree::uint32 v)
+{
+  while (v >= 0x80) {
+    out.push_back(static_cast<morphotree::uint8>(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back(static_cast<morphotree::uint8>(v));
+}
+
+template<class ContourSet, class ValueType>
+bool writeContourArchive(const std::string &path,
+  const morphotree::Box &domain,
+  const morphotree::MorphologicalTree<ValueType> &tree,
+  const std::vector<ContourSet> &contours)
+{
+  using MTree = morphotree::MorphologicalTree<ValueType>;
+  using morphotree::uint32;
+  using morphotree::int32;
+  using morphotree::uint8;
+  using NodePtr = typename MTree::NodePtr;
+
+  const uint32 n = tree.numberOfNodes();
+  std::vector<std::uint64_t> offsets(n + 1, 0);
+  std::vector<ArchiveNode> nodes(n);
+  std::vector<uint8> data;
+  std::vector<uint32> sorted;
+
+  for (uint32 id = 0; id < n; id++) {
+    NodePtr node = tree.node(id);
+    sorted.assign(contours[id].begin(), contours[id].end());
+    std::sort(sorted.begin(), sorted.end());
+
+    offsets[id] = data.size();
+    uint32 previous = 0;
+    for (uint32 pidx : sorted) {
+      appendVarint(data, pidx - previous);
+      previous = pidx;
+    }
+
+    nodes[id].parent = node->parent() == nullptr ? ArchiveNoParent : node->parent()->id();
+    nodes[id].level = static_cast<int32>(node->level());
+    nodes[id].size = sorted.size();
+  }
+  offsets[n] = data.size();
+
+  ArchiveHeader header;
+  std::memcpy(header.magic, ArchiveMagic, sizeof(ArchiveMagic));
+  header.version = ArchiveVersion;
+  header.width = domain.width();
+  header.height = domain.height();
+  header.numberOfNodes = n;
+  header.root = tree.root()->id();
+  header.dataSize = data.size();
+
+  std::ofstream out(path, std::ios::binary);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(std::uint64_t));
+  out.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(ArchiveNode));
+  out.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+  return static_cast<bool>(out);
+}
+
+inline ContourArchive::ContourArchive()
+  : base_{nullptr}, length_{0}
+{}
+
+inline ContourArchive::~ContourArchive()
+{
+  close();
+}
+
+inline bool ContourArchive::open(const std::string &path)
+{
+  close();
+
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(ArchiveHeader)) {
+    ::close(fd);
+    return false;
+  }
+
+  void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED)
+    return false;
+
+  base_ = static_cast<const morphotree::uint8*>(addr);
+  length_ = st.st_size;
+
+  // the header and the sizes of the sections must match the file
+  const ArchiveHeader *h = header();
+  const std::uint64_t expected = sizeof(ArchiveHeader)
+    + (static_cast<std::uint64_t>(h->numberOfNodes) + 1) * sizeof(std::uint64_t)
+    + static_cast<std::uint64_t>(h->numberOfNodes) * sizeof(ArchiveNode) + h->dataSize;
+  if (std::memcmp(h->magic, ArchiveMagic, sizeof(ArchiveMagic)) != 0
+      || h->version != ArchiveVersion || h->dataSize > length_ || expected != length_) {
+    close();
+    return false;
+  }
+
+  if (h->root >= h->numberOfNodes || offset(0) != 0 
+      || offset(h->numberOfNodes) != h->dataSize) {
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+inline void ContourArchive::close()
+{
+  if (base_ != nullptr)
+    munmap(const_cast<morphotree::uint8*>(base_), length_);
+
+  base_ = nullptr;
+  length_ = 0;
+}
+
+inline const ArchiveHeader *ContourArchive::header() const
+{
+  return reinterpret_cast<const ArchiveHeader*>(base_);
+}
+
+inline std::uint64_t ContourArchive::offset(uint32 id) const
+{
+  return reinterpret_cast<const std::uint64_t*>(base_ + sizeof(ArchiveHeader))[id];
+}
+
+inline bool ContourArchive::validRange(uint32 id) const
+{
+  return offset(id) <= offset(id + 1) && offset(id + 1) <= header()->dataSize;
+}
+
+inline const ArchiveNode *ContourArchive::nodes() const
+{
+  return reinterpret_cast<const ArchiveNode*>(base_ + sizeof(ArchiveHeader)
+    + (numberOfNodes() + 1) * sizeof(std::uint64_t));
+}
+
+inline const morphotree::uint8 *ContourArchive::data() const
+{
+  return reinterpret_cast<const morphotree::uint8*>(nodes() + numberOfNodes());
+}
+
+template<class Function>
+void ContourArchive::forEachPixel(uint32 id, Function fn) const
+{
+  if (!validRange(id))
+    return;
+
+  const morphotree::uint8 *p = data() + offset(id);
+  const morphotree::uint8 *end = data() + offset(id + 1);
+
+  // a uint32 takes at most 5 bytes (shifts 0 to 28)
+  uint32 pidx = 0;
+  while (p < end) {
+    uint32 delta = 0;
+    int shift = 0;
+    while (p < end && (*p & 0x80) && shift < 28) {
+      delta |= static_cast<uint32>(*p++ & 0x7F) << shift;
+      shift += 7;
+    }
+    if (p == end)
+      return;
+    delta |= static_cast<uint32>(*p++) << shift;
+
+    pidx += delta;
+    fn(pidx);
+  }
+}
+
+inline std::vector<morphotree::uint32> ContourArchive::contour(uint32 id) const
+{
+  std::vector<uint32> pixels;
+  // every pixel takes at least one byte, whatever the stored size says
+  if (validRange(id))
+    pixels.reserve(std::min<std::uint64_t>(contourSize(id), offset(id + 1) - offset(id)));
+  forEachPixel(id, [&pixels](uint32 pidx) { pixels.push_back(pidx); });
+  return pixels;
+}
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <morphotree/core/box.hpp>
+#include <morphotree/core/alias.hpp>
+#include <morphotree/adjacency/adjacency.hpp>
+#include <morphotree/tree/mtree.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+// Contour stored as a bitmap of the rows it covers. Each row keeps the words
+// [firstWord, firstWord + numberOfWords) of the image row (64 pixels per word,
+// aligned on the image columns), so the bitmaps of two nodes line up word by
+// word and the union of the children contours is a plain OR of words. Erasure
+// is a bit clear. Contours come in runs of neighbouring pixels, so a window
+// holds them in a fraction of the memory of one hashed entry per pixel.
+class BitmapContour
+{
+public:
+  using uint32 = morphotree::uint32;
+  using Word = std::uint64_t;
+  static const uint32 WordBits = 64;
+
+  // Forward iterator over the pixel indices of the set bits.
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = uint32;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const uint32*;
+    using reference = uint32;
+
+    const_iterator(const BitmapContour *contour, std::size_t word);
+
+    uint32 operator*() const;
+    const_iterator &operator++() { bits_ &= bits_ - 1; skip(); return *this; }
+    const_iterator operator++(int) { const_iterator it = *this; ++(*this); return it; }
+
+    bool operator==(const const_iterator &other) const
+    {
+      return word_ == other.word_ && bits_ == other.bits_;
+    }
+    bool operator!=(const const_iterator &other) const { return !(*this == other); }
+
+  private:
+    void skip();
+
+  private:
+    const BitmapContour *contour_;
+    std::size_t word_;
+    Word bits_;
+  };
+
+  BitmapContour() : width_{0}, top_{0}, numberOfRows_{0}, firstWord_{0}, numberOfWords_{0} {}
+
+  // Empty contour over rows [top, top + numberOfRows) and the words
+  // [firstWord, firstWord + numberOfWords) of an image "width" pixels wide.
+  BitmapContour(uint32 width, uint32 top, uint32 numberOfRows, uint32 firstWord,
+    uint32 numberOfWords);
+
+  void insert(uint32 pidx) { words_[wordIndex(pidx)] |= bit(pidx); }
+  void erase(uint32 pidx) { words_[wordIndex(pidx)] &= ~bit(pidx); }
+  bool contains(uint32 pidx) const;
+
+  // this |= other (the window of "other" must lie inside this one)
+  void merge(const BitmapContour &other);
+
+  std::size_t size() const;
+  std::size_t memory() const { return words_.size() * sizeof(Word); }
+
+  uint32 top() const { return top_; }
+  uint32 numberOfRows() const { return numberOfRows_; }
+  uint32 firstWord() const { return firstWord_; }
+  uint32 numberOfWords() const { return numberOfWords_; }
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, words_.size()); }
+
+private:
+  std::size_t wordIndex(uint32 pidx) const
+  {
+    return std::size_t(pidx / width_ - top_) * numberOfWords_ + (pidx % width_) / WordBits
+      - firstWord_;
+  }
+
+  Word bit(uint32 pidx) const { return Word(1) << ((pidx % width_) % WordBits); }
+
+private:
+  uint32 width_;
+  uint32 top_;
+  uint32 numberOfRows_;
+  uint32 firstWord_;
+  uint32 numberOfWords_;
+  std::vector<Word> words_;
+};
+
+// Incremental contour extraction with BitmapContour contours. The window of a
+// node covers the windows of its children and its cnps, so it holds every
+// pixel of its contour.
+template<class ValueType>
+std::vector<BitmapContour> extractCountorsBitmap(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree);
+
+// =================== [IMPLEMENTATION] ==========================
+inline BitmapContour::BitmapContour(uint32 width, uint32 top, uint32 numberOfRows,
+  uint32 firstWord, uint32 numberOfWords)
+  : width_{width}, top_{top}, numberOfRows_{numberOfRows}, firstWord_{firstWord},
+    numberOfWords_{numberOfWords}, words_(std::size_t(numberOfRows) * numberOfWords, 0)
+{}
+
+inline bool BitmapContour::contains(uint32 pidx) const
+{
+  const uint32 y = pidx / width_;
+  const uint32 w = (pidx % width_) / WordBits;
+  if (y < top_ || y >= top_ + numberOfRows_ || w < firstWord_ || w >= firstWord_ + numberOfWords_)
+    return false;
+
+  return (words_[wordIndex(pidx)] & bit(pidx)) != 0;
+}
+
+inline void BitmapContour::merge(const BitmapContour &other)
+{
+  for (uint32 r = 0; r < other.numberOfRows_; r++) {
+    const Word *src = other.words_.data() + std::size_t(r) * other.numberOfWords_;
+    Word *dst = words_.data() + std::size_t(other.top_ + r - top_) * numberOfWords_
+      + (other.firstWord_ - firstWord_);
+
+    for (uint32 w = 0; w < other.numberOfWords_; w++)
+      dst[w] |= src[w];
+  }
+}
+
+inline std::size_t BitmapContour::size() const
+{
+  std::size_t n = 0;
+  for (Word w : words_)
+    n += __builtin_popcountll(w);
+
+  return n;
+}
+
+inline BitmapContour::const_iterator::const_iterator(const BitmapContour *contour,
+  std::size_t word)
+  : contour_{contour}, word_{word},
+    bits_{word < contour->words_.size() ? contour->words_[word] : 0}
+{
+  skip();
+}
+
+inline void BitmapContour::const_iterator::skip()
+{
+  const std::size_t n = contour_->words_.size();
+  while (bits_ == 0 && word_ < n) {
+    word_++;
+    bits_ = word_ < n ? contour_->words_[word_] : 0;
+  }
+}
+
+inline morphotree::uint32 BitmapContour::const_iterator::operator*() const
+{
+  const BitmapContour &c = *contour_;
+  const uint32 y = c.top_ + uint32(word_ / c.numberOfWords_);
+  const uint32 x = (c.firstWord_ + uint32(word_ % c.numberOfWords_)) * WordBits
+    + __builtin_ctzll(bits_);
+
+  return y * c.width_ + x;
+}
+
+template<class ValueType>
+std::vector<BitmapContour> extractCountorsBitmap(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree)
+{
+  using MTree = morphotree::MorphologicalTree<ValueType>;
+  using morphotree::uint32;
+  using morphotree::uint8;
+  using morphotree::Box;
+  using NodePtr = typename MTree::NodePtr;
+
+  const uint32 width = domain.width();
+  std::vector<BitmapContour> contours(tree.numberOfNodes());
+  std::vector<uint8> ncount(domain.numberOfPoints());
+
+  tree.tranverse([&](NodePtr node){
+
+    // Window of node "N": rows [top, bottom] and words [left, right]
+    uint32 top = domain.height(), bottom = 0, left = width, right = 0;
+    for (NodePtr c : node->children()) {
+      const BitmapContour &cc = contours[c->id()];
+      top = std::min(top, cc.top());
+      bottom = std::max(bottom, cc.top() + cc.numberOfRows() - 1);
+      left = std::min(left, cc.firstWord());
+      right = std::max(right, cc.firstWord() + cc.numberOfWords() - 1);
+    }
+    for (uint32 pidx : node->cnps()) {
+      top = std::min(top, pidx / width);
+      bottom = std::max(bottom, pidx / width);
+      left = std::min(left, (pidx % width) / BitmapContour::WordBits);
+      right = std::max(right, (pidx % width) / BitmapContour::WordBits);
+    }
+
+    // Initialise contours of node "N"
+    BitmapContour &Ncontour = contours[node->id()];
+    Ncontour = BitmapContour(width, top, bottom - top + 1, left, right - left + 1);
+    for (NodePtr c : node->children())
+      Ncontour.merge(contours[c->id()]);
+
+    for (uint32 pidx : node->cnps()) {
+      for (uint32 qidx : adj->neighbours(pidx)) {
+        if (qidx == Box::UndefinedIndex || f[pidx] > f[qidx])
+          ncount[pidx]++;
+        else if (f[pidx] < f[qidx]) {
+          ncount[qidx]--;
+
+          if (ncount[qidx] == 0)
+            Ncontour.erase(qidx);
+        }
+      }
+
+      if (ncount[pidx] > 0)
+        Ncontour.insert(pidx);
+    }
+  });
+
+  return contours;
+}
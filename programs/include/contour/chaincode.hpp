@@ -0,0 +1,533 @@
+#pragma once
+
+#include <morphotree/core/box.hpp>
+#include <morphotree/core/alias.hpp>
+#include <morphotree/tree/mtree.hpp>
+
+#include "contour/padded.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Ordered contours of a component tree as closed crack-edge loops. A crack
+// edge is a side of a pixel of the node whose neighbour across that side is
+// outside the node. Edges are oriented clockwise around their pixel (the node
+// is on the right-hand side), so outer boundaries run clockwise and holes
+// counter-clockwise, and each edge is stored as one Freeman direction
+// (0: east, 1: south, 2: west, 3: north).
+//
+// The codes are stored in spans, runs of codes which follow each other along
+// a loop, and a loop is the list of the ids of its spans: a loop spliced from
+// the loops of the children refers to their spans instead of copying them.
+// Loops are identified by an id and shared between nodes: a node lists the
+// ids of its loops, and a loop of a child which is not touched by the cnps
+// of its parent is not copied at all.
+class ChainContours
+{
+public:
+  using uint32 = morphotree::uint32;
+  using uint8 = morphotree::uint8;
+
+  struct Range
+  {
+    uint32 begin;
+    uint32 end;
+  };
+
+  struct Span
+  {
+    uint32 start;   // edge id of the first code: 4*pidx + direction, pidx is the pixel inside the node
+    Range codes;
+  };
+
+  struct Loop
+  {
+    uint32 start;   // edge id of the first code of the loop
+    Range spans;    // range of the ids of its spans
+  };
+
+  ChainContours(uint32 numberOfNodes);
+
+  void beginNode(uint32 nodeId) { nodeRange_[nodeId].begin = loopIds_.size(); }
+  void beginLoop();
+  uint32 addCode(uint8 direction);
+
+  // Append the codes [begin, end), starting at edge "start", to the current
+  // loop as a new span, or join them to its last span when it is new as well
+  // and they follow it.
+  void addSpan(uint32 start, uint32 begin, uint32 end);
+  void reuseSpan(uint32 spanId);
+
+  // whether the current loop ends with a new span holding the last codes
+  bool endsWithNewCodes() const;
+
+  void endLoop();
+  void shareLoop(uint32 loopId) { loopIds_.push_back(loopId); }
+  void endNode(uint32 nodeId) { nodeRange_[nodeId].end = loopIds_.size(); }
+
+  uint32 numberOfLoops(uint32 nodeId) const;
+  uint32 loopId(uint32 nodeId, uint32 i) const { return loopIds_[nodeRange_[nodeId].begin + i]; }
+  const Loop &loop(uint32 loopId) const { return loops_[loopId]; }
+
+  uint32 numberOfSpans(uint32 loopId) const;
+  uint32 spanId(uint32 loopId, uint32 k) const { return spanIds_[loops_[loopId].spans.begin + k]; }
+  const Span &span(uint32 spanId) const { return spans_[spanId]; }
+  uint8 code(uint32 i) const { return codes_[i]; }
+
+  // number of distinct loops, of spans and of stored direction codes
+  uint32 numberOfStoredLoops() const { return loops_.size(); }
+  uint32 numberOfStoredSpans() const { return spans_.size(); }
+  uint32 numberOfCodes() const { return codes_.size(); }
+
+  // Pixel inside the node of every edge of the loop, in order (a pixel
+  // appears once per edge it owns).
+  std::vector<uint32> pixels(const morphotree::Box &domain, uint32 loopId) const;
+
+private:
+  std::vector<Range> nodeRange_;
+  std::vector<uint32> loopIds_;
+  std::vector<Loop> loops_;
+  std::vector<uint32> spanIds_;
+  std::vector<Span> spans_;
+  std::vector<uint8> codes_;
+  uint32 firstNewSpan_;   // spans created by the current loop
+};
+
+// First codes of the current spans during the extraction, to find the span
+// holding a code: a bitmap of the codes (with a summary bit per non-zero word)
+// searched backwards, and the span id of every marked code.
+class SpanStarts
+{
+public:
+  using uint32 = morphotree::uint32;
+  using Word = std::uint64_t;
+  static const uint32 WordBits = 64;
+
+  void resize(uint32 numberOfCodes);
+  void insert(uint32 i, uint32 spanId);
+  void erase(uint32 begin, uint32 end);   // marks of [begin, end)
+
+  // span of the last marked code at or before i (there must be one)
+  uint32 find(uint32 i) const;
+
+private:
+  std::vector<Word> words_;
+  std::vector<Word> summary_;
+  std::vector<uint32> spanIds_;
+};
+
+// Incremental extraction of the ordered contours. "AdjacencyType" is the
+// connectivity of the tree (InfAdjacency4C or InfAdjacency8C): with 8-connected
+// trees a loop goes through diagonal pinches, with 4-connected trees it does not.
+//
+// In post-order, the edges and links of the loops of the children only change
+// at the corners of the cnps pixels (the touched vertices). So a loop of a
+// child without an edge ending at a touched vertex is shared, and the other
+// ones are cut at those edges: the links at the touched vertices are followed
+// pixel by pixel and the spans between two cuts are reused, or split when a
+// cut falls inside them. The edges of the cnps get new codes, and so do the
+// runs shorter than ChainMinimumSpan codes left by a cut and the short spans
+// which follow new codes (they are merged with them). So the stored codes grow
+// with the number of cnps edges and cuts, not with the size of the touched
+// loops, and the walk of a loop steps over its spans instead of its codes
+// (only the span ids of a touched loop are copied).
+static const morphotree::uint32 ChainMinimumSpan = 16;
+
+template<class AdjacencyType, class ValueType>
+ChainContours extractChainContours(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  const morphotree::MorphologicalTree<ValueType> &tree);
+
+// =================== [IMPLEMENTATION] ==========================
+inline ChainContours::ChainContours(uint32 numberOfNodes)
+  : nodeRange_(numberOfNodes, Range{0, 0}), firstNewSpan_{0}
+{}
+
+inline void ChainContours::beginLoop()
+{
+  loopIds_.push_back(loops_.size());
+  const uint32 first = spanIds_.size();
+  loops_.push_back(Loop{0, Range{first, first}});
+  firstNewSpan_ = spans_.size();
+}
+
+inline ChainContours::uint32 ChainContours::addCode(uint8 direction)
+{
+  codes_.push_back(direction);
+  return codes_.size() - 1;
+}
+
+inline void ChainContours::addSpan(uint32 start, uint32 begin, uint32 end)
+{
+  if (loops_.back().spans.end > loops_.back().spans.begin && spanIds_.back() >= firstNewSpan_
+      && spans_[spanIds_.back()].codes.end == begin) {
+    spans_[spanIds_.back()].codes.end = end;
+    return;
+  }
+
+  spanIds_.push_back(spans_.size());
+  spans_.push_back(Span{start, Range{begin, end}});
+  loops_.back().spans.end = spanIds_.size();
+}
+
+inline bool ChainContours::endsWithNewCodes() const
+{
+  return loops_.back().spans.end > loops_.back().spans.begin && spanIds_.back() >= firstNewSpan_
+    && spans_[spanIds_.back()].codes.end == codes_.size();
+}
+
+inline void ChainContours::reuseSpan(uint32 spanId)
+{
+  spanIds_.push_back(spanId);
+  loops_.back().spans.end = spanIds_.size();
+}
+
+inline void ChainContours::endLoop()
+{
+  Loop &l = loops_.back();
+  l.start = spans_[spanIds_[l.spans.begin]].start;
+}
+
+inline ChainContours::uint32 ChainContours::numberOfLoops(uint32 nodeId) const
+{
+  return nodeRange_[nodeId].end - nodeRange_[nodeId].begin;
+}
+
+inline ChainContours::uint32 ChainContours::numberOfSpans(uint32 loopId) const
+{
+  return loops_[loopId].spans.end - loops_[loopId].spans.begin;
+}
+
+inline std::vector<ChainContours::uint32> ChainContours::pixels(
+  const morphotree::Box &domain, uint32 loopId) const
+{
+  using morphotree::int32;
+
+  // step to the pixel across direction d, and along direction d
+  static const int32 NX[] = { 0, 1, 0, -1 };
+  static const int32 NY[] = { -1, 0, 1, 0 };
+  static const int32 MX[] = { 1, 0, -1, 0 };
+  static const int32 MY[] = { 0, 1, 0, -1 };
+
+  const Loop &l = loops_[loopId];
+  const int32 width = domain.width();
+
+  std::vector<uint32> pixels;
+  for (uint32 k = l.spans.begin; k < l.spans.end; k++) {
+    const Span &span = spans_[spanIds_[k]];
+    int32 x = (span.start / 4) % width;
+    int32 y = (span.start / 4) / width;
+    for (uint32 i = span.codes.begin; i < span.codes.end; i++) {
+      pixels.push_back(y*width + x);
+      if (i + 1 == span.codes.end)
+        break;
+
+      const uint8 d = codes_[i];
+      const uint8 dn = codes_[i + 1];
+      if (dn == d) {                    // straight: pixel ahead
+        x += MX[d]; y += MY[d];
+      }
+      else if (dn == (d + 3) % 4) {     // left turn: pixel ahead and across
+        x += MX[d] + NX[d]; y += MY[d] + NY[d];
+      }
+      // right turn: same pixel
+    }
+  }
+
+  return pixels;
+}
+
+inline void SpanStarts::resize(uint32 numberOfCodes)
+{
+  words_.resize((numberOfCodes + WordBits - 1) / WordBits, 0);
+  summary_.resize((words_.size() + WordBits - 1) / WordBits, 0);
+  spanIds_.resize(numberOfCodes);
+}
+
+inline void SpanStarts::insert(uint32 i, uint32 spanId)
+{
+  const uint32 w = i / WordBits;
+  words_[w] |= Word(1) << (i % WordBits);
+  summary_[w / WordBits] |= Word(1) << (w % WordBits);
+  spanIds_[i] = spanId;
+}
+
+inline void SpanStarts::erase(uint32 begin, uint32 end)
+{
+  for (uint32 w = begin / WordBits; w * WordBits < end; w++) {
+    Word mask = ~Word(0);
+    if (w == begin / WordBits)
+      mask &= ~Word(0) << (begin % WordBits);
+    if (w == (end - 1) / WordBits)
+      mask &= ~Word(0) >> (WordBits - 1 - (end - 1) % WordBits);
+
+    words_[w] &= ~mask;
+    if (words_[w] == 0)
+      summary_[w / WordBits] &= ~(Word(1) << (w % WordBits));
+  }
+}
+
+inline SpanStarts::uint32 SpanStarts::find(uint32 i) const
+{
+  uint32 w = i / WordBits;
+  Word bits = words_[w] & (~Word(0) >> (WordBits - 1 - i % WordBits));
+  if (bits == 0) {
+    // last non-zero word before w
+    uint32 sw = w / WordBits;
+    Word summary = w % WordBits == 0 ? 0 
+      : summary_[sw] & (~Word(0) >> (WordBits - w % WordBits));
+    while (summary == 0)
+      summary = summary_[--sw];
+
+    w = sw * WordBits + WordBits - 1 - __builtin_clzll(summary);
+    bits = words_[w];
+  }
+
+  return spanIds_[w * WordBits + WordBits - 1 - __builtin_clzll(bits)];
+}
+
+template<class AdjacencyType, class ValueType>
+ChainContours extractChainContours(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  const morphotree::MorphologicalTree<ValueType> &tree)
+{
+  using MTree = morphotree::MorphologicalTree<ValueType>;
+  using morphotree::uint32;
+  using morphotree::int32;
+  using morphotree::uint8;
+  using NodePtr = typename MTree::NodePtr;
+
+  const bool diagonal = AdjacencyOffsets<AdjacencyType>::Size == 8;
+  static const uint32 NoSpan = 0xFFFFFFFF;
+
+  // step to the pixel across direction d, along direction d, and corner of
+  // the pixel where its edge of direction d starts
+  static const int32 NX[] = { 0, 1, 0, -1 };
+  static const int32 NY[] = { -1, 0, 1, 0 };
+  static const int32 MX[] = { 1, 0, -1, 0 };
+  static const int32 MY[] = { 0, 1, 0, -1 };
+  static const int32 CX[] = { 0, 1, 1, 0 };
+  static const int32 CY[] = { 0, 0, 1, 1 };
+
+  const int32 width = domain.width();
+  const int32 height = domain.height();
+
+  ChainContours chains(tree.numberOfNodes());
+
+  // current code of every edge and edge of every code
+  std::vector<uint32> pos(4 * domain.numberOfPoints());
+  std::vector<uint32> edgeOf;
+
+  // loop of the last node using every span, position of the span in it, and
+  // first codes of the spans of the current loops
+  std::vector<uint32> owner;
+  std::vector<uint32> slot;
+  SpanStarts spanStarts;
+
+  std::vector<uint32> visited(4 * domain.numberOfPoints(), 0);
+  std::vector<uint32> isCnps(domain.numberOfPoints(), 0);
+  std::vector<uint32> touched((width + 1) * (height + 1), 0);
+  std::vector<uint32> vertices;
+  std::vector<uint32> touchedLoop;
+  std::vector<uint32> starts;
+  std::vector<uint32> cuts;
+  uint32 epoch = 0;
+
+  tree.tranverse([&](NodePtr node){
+    const ValueType level = node->level();
+    epoch++;
+
+    auto in = [&f, width, height, level](int32 x, int32 y) {
+      return 0 <= x && x < width && 0 <= y && y < height && f[y*width + x] >= level;
+    };
+
+    // next edge along the loop, keeping the node on the right
+    auto next = [&](uint32 e) {
+      int32 x = (e / 4) % width, y = (e / 4) / width;
+      int d = e % 4;
+      const int32 rx = x + MX[d], ry = y + MY[d];      // ahead-right
+      const int32 lx = rx + NX[d], ly = ry + NY[d];    // ahead-left
+      const bool aheadRight = in(rx, ry);
+      const bool aheadLeft = in(lx, ly);
+
+      if (aheadLeft && (aheadRight || diagonal)) {
+        x = lx; y = ly; d = (d + 3) % 4;
+      }
+      else if (aheadRight) {
+        x = rx; y = ry;
+      }
+      else
+        d = (d + 1) % 4;
+
+      return static_cast<uint32>(4*(y*width + x) + d);
+    };
+
+    auto contains = [&chains](uint32 s, uint32 i) {
+      const ChainContours::Range r = chains.span(s).codes;
+      return r.begin <= i && i < r.end;
+    };
+
+    for (uint32 pidx : node->cnps())
+      isCnps[pidx] = epoch;
+
+    vertices.clear();
+    for (uint32 pidx : node->cnps()) {
+      const int32 px = pidx % width, py = pidx / width;
+      for (int c = 0; c < 4; c++) {
+        const uint32 v = (py + CY[c])*(width + 1) + px + CX[c];
+        if (touched[v] != epoch) {
+          touched[v] = epoch;
+          vertices.push_back(v);
+        }
+      }
+    }
+
+    // edges at the touched vertices of the pixels around them which are surely
+    // in the node (all of them, but for a 4-connected tree the pixel across an
+    // open diagonal pinch): the loops are walked from the edges starting at a
+    // touched vertex, and cut at the (old) edges ending at one. The edge of
+    // direction c starts at corner c of its pixel and the edge of direction
+    // c-1 ends there.
+    starts.clear();
+    cuts.clear();
+    for (uint32 v : vertices) {
+      const int32 vx = v % (width + 1), vy = v / (width + 1);
+      for (int c = 0; c < 4; c++) {
+        const int32 x = vx - CX[c], y = vy - CY[c];
+        if (!in(x, y))
+          continue;
+
+        const uint32 xidx = y*width + x;
+        const bool cnps = isCnps[xidx] == epoch;
+        if (!diagonal && !cnps && !in(2*vx - 1 - x, y) && !in(x, 2*vy - 1 - y))
+          continue;
+
+        const int ds = c, de = (c + 3) % 4;
+        if (!in(x + NX[ds], y + NY[ds]))
+          starts.push_back(4*xidx + ds);
+        if (!cnps && !in(x + NX[de], y + NY[de]))
+          cuts.push_back(pos[4*xidx + de]);
+      }
+    }
+    std::sort(cuts.begin(), cuts.end());
+    cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+
+    // loops of the children with a cut are replaced by the walked ones
+    touchedLoop.resize(chains.numberOfStoredLoops(), 0);
+    for (uint32 i : cuts)
+      touchedLoop[owner[spanStarts.find(i)]] = epoch;
+
+    const uint32 firstLoop = chains.numberOfStoredLoops();
+    const uint32 firstSpan = chains.numberOfStoredSpans();
+    chains.beginNode(node->id());
+
+    for (uint32 e0 : starts) {
+      if (visited[e0] == epoch)
+        continue;
+
+      chains.beginLoop();
+      uint32 e = e0;
+      uint32 s = NoSpan;   // span of a child loop holding the current run, and its position there
+      uint32 k = 0;
+      do {
+        if (isCnps[e / 4] == epoch) {
+          // run of new edges
+          const uint32 first = e;
+          const uint32 begin = chains.numberOfCodes();
+          do {
+            visited[e] = epoch;
+            pos[e] = chains.addCode(e % 4);
+            edgeOf.push_back(e);
+            e = next(e);
+          } while (e != e0 && isCnps[e / 4] == epoch);
+
+          chains.addSpan(first, begin, chains.numberOfCodes());
+          s = NoSpan;
+        }
+        else {
+          // run of old codes up to the end of their span or the next cut:
+          // the same span after a cut whose link did not change, the next
+          // span of the child loop after an unchanged link, or a lookup
+          const uint32 i = pos[e];
+          if (s != NoSpan && !contains(s, i)) {
+            const uint32 l = owner[s];
+            const uint32 kn = (k + 1) % chains.numberOfSpans(l);
+            s = NoSpan;
+            if (contains(chains.spanId(l, kn), i)) {
+              s = chains.spanId(l, kn);
+              k = kn;
+            }
+          }
+          if (s == NoSpan) {
+            s = spanStarts.find(i);
+            k = slot[s];
+          }
+
+          const ChainContours::Range r = chains.span(s).codes;
+          uint32 last = r.end - 1;
+          auto cut = std::lower_bound(cuts.begin(), cuts.end(), i);
+          if (cut != cuts.end() && *cut < last)
+            last = *cut;
+
+          const bool whole = i == r.begin && last + 1 == r.end;
+          if (last + 1 - i < ChainMinimumSpan && (!whole || chains.endsWithNewCodes())) {
+            // short runs split by a cut, and short spans after new codes, are
+            // copied to join the new codes
+            const uint32 begin = chains.numberOfCodes();
+            for (uint32 c = i; c <= last; c++) {
+              pos[edgeOf[c]] = chains.addCode(chains.code(c));
+              edgeOf.push_back(edgeOf[c]);
+            }
+            chains.addSpan(e, begin, chains.numberOfCodes());
+          }
+          else if (whole)
+            chains.reuseSpan(s);
+          else
+            chains.addSpan(e, i, last + 1);
+
+          visited[e] = epoch;
+          visited[edgeOf[last]] = epoch;
+          e = next(edgeOf[last]);
+        }
+      } while (e != e0);
+      chains.endLoop();
+    }
+
+    // untouched loops of the children
+    for (NodePtr c : node->children()) {
+      for (uint32 i = 0; i < chains.numberOfLoops(c->id()); i++) {
+        const uint32 id = chains.loopId(c->id(), i);
+        const uint32 e = chains.loop(id).start;
+        const uint32 pidx = e / 4;
+        const int32 x = pidx % width, y = pidx / width;
+        if (touchedLoop[id] != epoch && !in(x + NX[e % 4], y + NY[e % 4]))
+          chains.shareLoop(id);
+      }
+    }
+
+    chains.endNode(node->id());
+
+    // the walked loops are the current ones of their spans (the new spans
+    // replace the ones they were split from)
+    owner.resize(chains.numberOfStoredSpans());
+    slot.resize(chains.numberOfStoredSpans());
+    spanStarts.resize(chains.numberOfCodes());
+    for (uint32 l = firstLoop; l < chains.numberOfStoredLoops(); l++) {
+      for (uint32 k = 0; k < chains.numberOfSpans(l); k++) {
+        const uint32 s = chains.spanId(l, k);
+        owner[s] = l;
+        slot[s] = k;
+        if (s >= firstSpan) {
+          const ChainContours::Range r = chains.span(s).codes;
+          spanStarts.erase(r.begin, r.end);
+          spanStarts.insert(r.begin, s);
+        }
+      }
+    }
+  });
+
+  return chains;
+}
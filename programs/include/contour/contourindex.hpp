@@ -0,0 +1,134 @@
+#pragma once
+
+#include <morphotree/core/box.hpp>
+#include <morphotree/core/alias.hpp>
+#include <morphotree/adjacency/adjacency.hpp>
+#include <morphotree/tree/mtree.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Implicit contours of all the nodes of a max-tree. A pixel p of node N is on
+// the contour of N exactly when level(N) is above the lowest value among the
+// neighbours of p (out-of-domain neighbours count as minus infinity), so the
+// index only stores that threshold for every pixel plus the pre-order range
+// of every node:
+//
+//   p in contour(N)  <=>  pre(N) <= pre(node of p) < end(N)  and  level(N) > threshold(p)
+//
+// It is built in one pass over the pixels and answers the membership in O(1);
+// a contour is enumerated by filtering the cnps of the subtree, which are
+// contiguous in pre-order. No contour set is stored.
+//
+// The contour adjacency must be contained in the tree adjacency, so that
+// every neighbour of p not lower than level(N) belongs to N.
+template<class ValueType>
+class ContourIndex
+{
+public:
+  using uint32 = morphotree::uint32;
+  using int32 = morphotree::int32;
+  using MTree = morphotree::MorphologicalTree<ValueType>;
+  using NodePtr = typename MTree::NodePtr;
+
+  ContourIndex(const morphotree::Box &domain, const std::vector<ValueType> &f,
+    std::shared_ptr<morphotree::Adjacency> adj, const MTree &tree);
+
+  // Is pixel "pidx" on the contour of node "nodeId"?
+  bool contains(uint32 nodeId, uint32 pidx) const;
+
+  template<class Function>
+  void forEachPixel(uint32 nodeId, Function fn) const;
+
+  std::vector<uint32> contour(uint32 nodeId) const;
+
+private:
+  bool inSubtree(uint32 nodeId, uint32 pidx) const
+  {
+    const uint32 pre = pre_[tree_.smallComponent(pidx)->id()];
+    return pre_[nodeId] <= pre && pre < end_[nodeId];
+  }
+
+private:
+  const MTree &tree_;
+  std::vector<int32> threshold_;    // lowest neighbour value, or Below for border pixels
+  std::vector<uint32> pre_;         // pre-order position of every node
+  std::vector<uint32> end_;         // pre-order position after its subtree
+  std::vector<NodePtr> preorder_;
+
+  static const int32 Below = std::numeric_limits<int32>::min();
+};
+
+// =================== [IMPLEMENTATION] ==========================
+template<class ValueType>
+ContourIndex<ValueType>::ContourIndex(const morphotree::Box &domain,
+  const std::vector<ValueType> &f, std::shared_ptr<morphotree::Adjacency> adj,
+  const MTree &tree)
+  : tree_{tree}, threshold_(domain.numberOfPoints()), pre_(tree.numberOfNodes()),
+    end_(tree.numberOfNodes())
+{
+  using morphotree::Box;
+
+  for (uint32 pidx = 0; pidx < domain.numberOfPoints(); pidx++) {
+    int32 lowest = std::numeric_limits<int32>::max();
+    for (uint32 qidx : adj->neighbours(pidx)) {
+      if (qidx == Box::UndefinedIndex) {
+        lowest = Below;
+        break;
+      }
+      lowest = std::min(lowest, static_cast<int32>(f[qidx]));
+    }
+    threshold_[pidx] = lowest;
+  }
+
+  // pre-order numbering; "end" is filled when a node is left
+  preorder_.reserve(tree.numberOfNodes());
+  std::vector<std::pair<NodePtr, bool>> stack = { {tree.root(), false} };
+  while (!stack.empty()) {
+    std::pair<NodePtr, bool> top = stack.back();
+    stack.pop_back();
+
+    NodePtr node = top.first;
+    if (top.second) {
+      end_[node->id()] = preorder_.size();
+      continue;
+    }
+
+    pre_[node->id()] = preorder_.size();
+    preorder_.push_back(node);
+    stack.emplace_back(node, true);
+    for (NodePtr c : node->children())
+      stack.emplace_back(c, false);
+  }
+}
+
+template<class ValueType>
+bool ContourIndex<ValueType>::contains(uint32 nodeId, uint32 pidx) const
+{
+  return inSubtree(nodeId, pidx)
+    && static_cast<int32>(tree_.node(nodeId)->level()) > threshold_[pidx];
+}
+
+template<class ValueType>
+template<class Function>
+void ContourIndex<ValueType>::forEachPixel(uint32 nodeId, Function fn) const
+{
+  const int32 level = static_cast<int32>(tree_.node(nodeId)->level());
+  for (uint32 i = pre_[nodeId]; i < end_[nodeId]; i++) {
+    for (uint32 pidx : preorder_[i]->cnps()) {
+      if (level > threshold_[pidx])
+        fn(pidx);
+    }
+  }
+}
+
+template<class ValueType>
+std::vector<morphotree::uint32> ContourIndex<ValueType>::contour(uint32 nodeId) const
+{
+  std::vector<uint32> pixels;
+  forEachPixel(nodeId, [&pixels](uint32 pidx) { pixels.push_back(pidx); });
+  return pixels;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <morphotree/core/box.hpp>
+#include <morphotree/core/alias.hpp>
+#include <morphotree/adjacency/adjacency.hpp>
+#include <morphotree/tree/mtree.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Sizes of the contours of every node, without the contours. "pixels[id]" is
+// the number of contour pixels of node "id" and "edges[id]" the number of its
+// contour edges (sides): the pairs of adjacent pixels p, q with p in the node
+// and q outside of it (or outside the domain).
+struct ContourCounts
+{
+  std::vector<morphotree::uint32> pixels;
+  std::vector<std::uint64_t> edges;
+};
+
+// Same traversal and "ncount" transitions as the incremental extraction, but
+// each node only keeps two integers: the sums of its children plus the pixels
+// that enter the contour (ncount > 0 after the cnps scan) minus the ones that
+// leave it (ncount reaching 0), and one edge per increment minus one per
+// decrement of ncount. It takes O(pixels) time and ncount as extra memory.
+template<class ValueType>
+ContourCounts computeContourCounts(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree);
+
+// =================== [IMPLEMENTATION] ==========================
+template<class ValueType>
+ContourCounts computeContourCounts(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree)
+{
+  using MTree = morphotree::MorphologicalTree<ValueType>;
+  using morphotree::uint32;
+  using morphotree::uint8;
+  using morphotree::Box;
+  using NodePtr = typename MTree::NodePtr;
+
+  ContourCounts counts;
+  counts.pixels.resize(tree.numberOfNodes(), 0);
+  counts.edges.resize(tree.numberOfNodes(), 0);
+  std::vector<uint8> ncount(domain.numberOfPoints());
+
+  tree.tranverse([&f, &counts, &ncount, adj](NodePtr node){
+    uint32 &Npixels = counts.pixels[node->id()];
+    std::uint64_t &Nedges = counts.edges[node->id()];
+    for (NodePtr c : node->children()) {
+      Npixels += counts.pixels[c->id()];
+      Nedges += counts.edges[c->id()];
+    }
+
+    for (uint32 pidx : node->cnps()) {
+      for (uint32 qidx : adj->neighbours(pidx)) {
+        if (qidx == Box::UndefinedIndex || f[pidx] > f[qidx]) {
+          ncount[pidx]++;
+          Nedges++;
+        }
+        else if (f[pidx] < f[qidx]) {
+          ncount[qidx]--;
+          Nedges--;
+
+          if (ncount[qidx] == 0)
+            Npixels--;
+        }
+      }
+
+      if (ncount[pidx] > 0)
+        Npixels++;
+    }
+  });
+
+  return counts;
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <morphotree/core/box.hpp>
+#include <morphotree/core/alias.hpp>
+#include <morphotree/adjacency/adjacency.hpp>
+#include <morphotree/tree/mtree.hpp>
+
+#include <vector>
+#include <memory>
+#include <unordered_set>
+
+// Delta-encoded contours of a component tree. Instead of a full set per node,
+// each node stores the pixels it adds to the contour (its cnps which have a
+// lower or out-of-domain neighbour) and the pixels of its children contours
+// it removes (the ones whose ncount drops to zero). Every pixel is added at
+// most once and removed at most once, so memory is O(pixels).
+//
+// The contour of a node N is the set of pixels added in the subtree of N
+// minus the pixels removed in the subtree of N.
+class DeltaContours
+{
+public:
+  using uint32 = morphotree::uint32;
+
+  struct Range
+  {
+    uint32 begin;
+    uint32 end;
+  };
+
+  DeltaContours(uint32 numberOfNodes);
+
+  void beginNode(uint32 nodeId);
+  void add(uint32 pidx) { added_.push_back(pidx); }
+  void remove(uint32 pidx) { removed_.push_back(pidx); }
+  void endNode(uint32 nodeId);
+
+  uint32 numberOfAdded(uint32 nodeId) const;
+  uint32 numberOfRemoved(uint32 nodeId) const;
+  uint32 numberOfEntries() const { return added_.size() + removed_.size(); }
+
+  // Rebuild the full contour of "node" by walking its subtree.
+  template<class ValueType>
+  std::unordered_set<uint32> materialize(
+    typename morphotree::MorphologicalTree<ValueType>::NodePtr node) const;
+
+private:
+  std::vector<Range> addedRange_;
+  std::vector<Range> removedRange_;
+  std::vector<uint32> added_;
+  std::vector<uint32> removed_;
+};
+
+template<class ValueType>
+DeltaContours extractDeltaContours(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree);
+
+// =================== [IMPLEMENTATION] ==========================
+inline DeltaContours::DeltaContours(uint32 numberOfNodes)
+  : addedRange_(numberOfNodes, Range{0, 0}),
+    removedRange_(numberOfNodes, Range{0, 0})
+{}
+
+inline void DeltaContours::beginNode(uint32 nodeId)
+{
+  addedRange_[nodeId].begin = added_.size();
+  removedRange_[nodeId].begin = removed_.size();
+}
+
+inline void DeltaContours::endNode(uint32 nodeId)
+{
+  addedRange_[nodeId].end = added_.size();
+  removedRange_[nodeId].end = removed_.size();
+}
+
+inline DeltaContours::uint32 DeltaContours::numberOfAdded(uint32 nodeId) const
+{
+  return addedRange_[nodeId].end - addedRange_[nodeId].begin;
+}
+
+inline DeltaContours::uint32 DeltaContours::numberOfRemoved(uint32 nodeId) const
+{
+  return removedRange_[nodeId].end - removedRange_[nodeId].begin;
+}
+
+template<class ValueType>
+std::unordered_set<DeltaContours::uint32> DeltaContours::materialize(
+  typename morphotree::MorphologicalTree<ValueType>::NodePtr node) const
+{
+  using NodePtr = typename morphotree::MorphologicalTree<ValueType>::NodePtr;
+
+  std::unordered_set<uint32> contour;
+  std::vector<NodePtr> stack{node};
+  std::vector<NodePtr> subtree;
+
+  while (!stack.empty()) {
+    NodePtr n = stack.back();
+    stack.pop_back();
+    subtree.push_back(n);
+
+    for (NodePtr c : n->children())
+      stack.push_back(c);
+  }
+
+  // every removed pixel was added by a descendant, so add first and erase after
+  for (NodePtr n : subtree) {
+    const Range &r = addedRange_[n->id()];
+    contour.insert(added_.begin() + r.begin, added_.begin() + r.end);
+  }
+
+  for (NodePtr n : subtree) {
+    const Range &r = removedRange_[n->id()];
+    for (uint32 i = r.begin; i < r.end; i++)
+      contour.erase(removed_[i]);
+  }
+
+  return contour;
+}
+
+template<class ValueType>
+DeltaContours extractDeltaContours(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree)
+{
+  using MTree = morphotree::MorphologicalTree<ValueType>;
+  using morphotree::uint32;
+  using morphotree::uint8;
+  using morphotree::Box;
+  using NodePtr = typename MTree::NodePtr;
+
+  DeltaContours delta(tree.numberOfNodes());
+  std::vector<uint8> ncount(domain.numberOfPoints());
+
+  tree.tranverse([&f, &delta, &ncount, adj](NodePtr node){
+    delta.beginNode(node->id());
+
+    for (uint32 pidx : node->cnps()) {
+      for (uint32 qidx : adj->neighbours(pidx)) {
+        if (qidx == Box::UndefinedIndex || f[pidx] > f[qidx])
+          ncount[pidx]++;
+        else if (f[pidx] < f[qidx]) {
+          ncount[qidx]--;
+
+          if (ncount[qidx] == 0)
+            delta.remove(qidx);
+        }
+      }
+
+      if (ncount[pidx] > 0)
+        delta.add(pidx);
+    }
+
+    delta.endNode(node->id());
+  });
+
+  return delta;
+}
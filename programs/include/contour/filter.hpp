@@ -0,0 +1,51 @@
+#pragma once
+
+#include <morphotree/core/alias.hpp>
+#include <morphotree/tree/mtree.hpp>
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+// Filter "tree" in place with MorphologicalTree::idirectFilter and return the
+// contours of the filtered tree, taken from "contours" (the contours of the
+// tree before filtering, which are consumed).
+//
+// The direct rule gives the cnps of a pruned node to its closest kept
+// ancestor, which already contains them, so every kept node has the same
+// pixels, hence the same contour, before and after filtering: the sets are
+// moved to the new node ids and nothing is recomputed. Sweeping a growing
+// threshold (e.g. of area) can be done by filtering the already filtered tree
+// with the contours returned by the previous call.
+template<class ContourSet, class ValueType>
+std::vector<ContourSet> idirectFilterContours(
+  morphotree::MorphologicalTree<ValueType> &tree,
+  std::vector<ContourSet> &contours,
+  std::function<bool(typename morphotree::MorphologicalTree<ValueType>::NodePtr)> keep);
+
+// =================== [IMPLEMENTATION] ==========================
+template<class ContourSet, class ValueType>
+std::vector<ContourSet> idirectFilterContours(
+  morphotree::MorphologicalTree<ValueType> &tree,
+  std::vector<ContourSet> &contours,
+  std::function<bool(typename morphotree::MorphologicalTree<ValueType>::NodePtr)> keep)
+{
+  using MTree = morphotree::MorphologicalTree<ValueType>;
+  using morphotree::uint32;
+  using NodePtr = typename MTree::NodePtr;
+
+  // a pixel of every kept node (its cnps stay in it) and the old id
+  std::vector<std::pair<uint32, uint32>> kept;
+  tree.tranverse([&kept, &keep, &tree](NodePtr node) {
+    if (node == tree.root() || keep(node))
+      kept.emplace_back(node->cnps().front(), node->id());
+  });
+
+  tree.idirectFilter(keep);
+
+  std::vector<ContourSet> filtered(tree.numberOfNodes());
+  for (const std::pair<uint32, uint32> &k : kept)
+    filtered[tree.smallComponent(k.first)->id()] = std::move(contours[k.second]);
+
+  return filtered;
+}
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <morphotree/core/box.hpp>
+#include <morphotree/core/alias.hpp>
+#include <morphotree/adjacency/adjacency.hpp>
+#include <morphotree/tree/mtree.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+// Open-addressing hash set of pixel indices. The slots are one flat array of
+// uint32 (EmptySlot marks a free slot) probed linearly from a multiplicative
+// hash, with a power-of-two capacity kept at most 3/4 full. Erasure moves the
+// following entries of the probe run back into the freed slot (backward
+// shift), so there are no tombstones and lookups never slow down after many
+// erasures.
+class FlatSet
+{
+public:
+  using uint32 = morphotree::uint32;
+  static const uint32 EmptySlot = 0xFFFFFFFF;
+
+  // Forward iterator over the occupied slots.
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = uint32;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const uint32*;
+    using reference = const uint32&;
+
+    const_iterator(const uint32 *slot, const uint32 *end) : slot_{slot}, end_{end} { skip(); }
+
+    reference operator*() const { return *slot_; }
+    const_iterator &operator++() { ++slot_; skip(); return *this; }
+    const_iterator operator++(int) { const_iterator it = *this; ++(*this); return it; }
+
+    bool operator==(const const_iterator &other) const { return slot_ == other.slot_; }
+    bool operator!=(const const_iterator &other) const { return slot_ != other.slot_; }
+
+  private:
+    void skip() { while (slot_ != end_ && *slot_ == EmptySlot) ++slot_; }
+
+  private:
+    const uint32 *slot_;
+    const uint32 *end_;
+  };
+
+  FlatSet() : size_{0}, shift_{32} {}
+
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  std::size_t capacity() const { return slots_.size(); }
+
+  // Make room for "n" elements without rehashing.
+  void reserve(std::size_t n);
+
+  bool insert(uint32 pidx);
+  bool erase(uint32 pidx);
+  bool contains(uint32 pidx) const;
+
+  const_iterator begin() const { return const_iterator(slots_.data(), slots_.data() + slots_.size()); }
+  const_iterator end() const
+  {
+    return const_iterator(slots_.data() + slots_.size(), slots_.data() + slots_.size());
+  }
+
+private:
+  std::size_t home(uint32 pidx) const
+  {
+    return static_cast<uint32>(pidx * 0x9E3779B9u) >> shift_;
+  }
+
+  std::size_t mask() const { return slots_.size() - 1; }
+  void rehash(std::size_t capacity);
+
+private:
+  std::vector<uint32> slots_;
+  std::size_t size_;
+  unsigned shift_;   // 32 - log2(capacity)
+};
+
+// Incremental contour extraction with FlatSet contours. Every node reserves
+// the sum of the sizes of its children contours plus its cnps before merging,
+// so its table is allocated once (the contour never gets larger than that).
+template<class ValueType>
+std::vector<FlatSet> extractCountorsFlatSet(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree);
+
+// =================== [IMPLEMENTATION] ==========================
+inline void FlatSet::reserve(std::size_t n)
+{
+  std::size_t capacity = slots_.empty() ? 8 : slots_.size();
+  while (4 * n > 3 * capacity)
+    capacity *= 2;
+
+  if (capacity > slots_.size())
+    rehash(capacity);
+}
+
+inline void FlatSet::rehash(std::size_t capacity)
+{
+  std::vector<uint32> old(capacity, static_cast<uint32>(EmptySlot));
+  old.swap(slots_);
+
+  shift_ = 32;
+  for (std::size_t c = capacity; c > 1; c >>= 1)
+    shift_--;
+
+  for (uint32 pidx : old) {
+    if (pidx == EmptySlot)
+      continue;
+
+    std::size_t i = home(pidx);
+    while (slots_[i] != EmptySlot)
+      i = (i + 1) & mask();
+    slots_[i] = pidx;
+  }
+}
+
+inline bool FlatSet::insert(uint32 pidx)
+{
+  reserve(size_ + 1);
+
+  std::size_t i = home(pidx);
+  while (slots_[i] != EmptySlot) {
+    if (slots_[i] == pidx)
+      return false;
+    i = (i + 1) & mask();
+  }
+
+  slots_[i] = pidx;
+  size_++;
+  return true;
+}
+
+inline bool FlatSet::contains(uint32 pidx) const
+{
+  if (slots_.empty())
+    return false;
+
+  std::size_t i = home(pidx);
+  while (slots_[i] != EmptySlot) {
+    if (slots_[i] == pidx)
+      return true;
+    i = (i + 1) & mask();
+  }
+
+  return false;
+}
+
+inline bool FlatSet::erase(uint32 pidx)
+{
+  if (slots_.empty())
+    return false;
+
+  std::size_t hole = home(pidx);
+  while (slots_[hole] != pidx) {
+    if (slots_[hole] == EmptySlot)
+      return false;
+    hole = (hole + 1) & mask();
+  }
+
+  // move back every entry of the run that may not sit after the hole (its
+  // home is not in the cyclic range (hole, i])
+  std::size_t i = (hole + 1) & mask();
+  while (slots_[i] != EmptySlot) {
+    std::size_t h = home(slots_[i]);
+    if (((i - h) & mask()) >= ((i - hole) & mask())) {
+      slots_[hole] = slots_[i];
+      hole = i;
+    }
+    i = (i + 1) & mask();
+  }
+
+  slots_[hole] = EmptySlot;
+  size_--;
+  return true;
+}
+
+template<class ValueType>
+std::vector<FlatSet> extractCountorsFlatSet(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree)
+{
+  using MTree = morphotree::MorphologicalTree<ValueType>;
+  using morphotree::uint32;
+  using morphotree::uint8;
+  using morphotree::Box;
+  using NodePtr = typename MTree::NodePtr;
+
+  std::vector<FlatSet> contours(tree.numberOfNodes());
+  std::vector<uint8> ncount(domain.numberOfPoints());
+
+  tree.tranverse([&f, &contours, &ncount, adj](NodePtr node){
+
+    // Initialise contours of node "N"
+    FlatSet &Ncontour = contours[node->id()];
+    std::size_t bound = node->cnps().size();
+    for (NodePtr c : node->children())
+      bound += contours[c->id()].size();
+    Ncontour.reserve(bound);
+
+    for (NodePtr c : node->children()) {
+      for (uint32 pidx : contours[c->id()])
+        Ncontour.insert(pidx);
+    }
+
+    for (uint32 pidx : node->cnps()) {
+      for (uint32 qidx : adj->neighbours(pidx)) {
+        if (qidx == Box::UndefinedIndex || f[pidx] > f[qidx])
+          ncount[pidx]++;
+        else if (f[pidx] < f[qidx]) {
+          ncount[qidx]--;
+
+          if (ncount[qidx] == 0)
+            Ncontour.erase(qidx);
+        }
+      }
+
+      if (ncount[pidx] > 0)
+        Ncontour.insert(pidx);
+    }
+  });
+
+  return contours;
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include "contour/counts.hpp"
+
+#include <morphotree/core/box.hpp>
+#include <morphotree/core/alias.hpp>
+#include <morphotree/adjacency/adjacency.hpp>
+#include <morphotree/tree/mtree.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Structure-of-arrays copy of a max-tree in post-order. Node i of the flat
+// tree is the i-th node of the post-order traversal, so the children of a
+// node come before it and its subtree is the range [first[i], i]. Every array
+// is contiguous:
+//
+//   parent[i]                               parent id (the root is its own parent)
+//   level[i]                                level of the node
+//   children[childOffset[i] .. childOffset[i+1])   children ids
+//   pixels[pixelOffset[i] .. pixelOffset[i+1])     cnps of the node
+//
+// The cnps slices follow the same order, so the pixels of a subtree are the
+// contiguous range [pixelOffset[first[i]], pixelOffset[i+1]). "originalId"
+// maps a flat id back to the id of the node in the MorphologicalTree.
+template<class ValueType>
+struct FlatTree
+{
+  using uint32 = morphotree::uint32;
+
+  std::vector<uint32> parent;
+  std::vector<ValueType> level;
+  std::vector<uint32> first;
+  std::vector<uint32> childOffset;
+  std::vector<uint32> children;
+  std::vector<uint32> pixelOffset;
+  std::vector<uint32> pixels;
+  std::vector<uint32> originalId;
+
+  uint32 numberOfNodes() const { return static_cast<uint32>(parent.size()); }
+  uint32 root() const { return numberOfNodes() - 1; }
+};
+
+template<class ValueType>
+FlatTree<ValueType> flattenTree(const morphotree::MorphologicalTree<ValueType> &tree);
+
+// Incremental contour extraction on a flat tree: a single scan of the nodes
+// in id order. contours[i] is the contour of flat node i.
+template<class ContourSet, class ValueType>
+std::vector<ContourSet> extractCountorsFlatTree(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const FlatTree<ValueType> &tree);
+
+// Contour sizes of every flat node (see counts.hpp); the sums of the
+// children are pushed to the parent when a node is done, so the children
+// arrays are not read.
+template<class ValueType>
+ContourCounts computeContourCountsFlatTree(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const FlatTree<ValueType> &tree);
+
+// =================== [IMPLEMENTATION] ==========================
+template<class ValueType>
+FlatTree<ValueType> flattenTree(const morphotree::MorphologicalTree<ValueType> &tree)
+{
+  using MTree = morphotree::MorphologicalTree<ValueType>;
+  using morphotree::uint32;
+  using NodePtr = typename MTree::NodePtr;
+
+  const uint32 n = tree.numberOfNodes();
+  FlatTree<ValueType> flat;
+  flat.parent.resize(n);
+  flat.level.resize(n);
+  flat.first.resize(n);
+  flat.childOffset.reserve(n + 1);
+  flat.children.reserve(n - 1);
+  flat.pixelOffset.reserve(n + 1);
+  flat.originalId.reserve(n);
+
+  // flat id of every node, given when the node is left
+  std::vector<uint32> flatId(n);
+  std::vector<std::pair<NodePtr, bool>> stack = { {tree.root(), false} };
+  std::vector<uint32> enter;            // flat id of the first node of the subtree
+  while (!stack.empty()) {
+    std::pair<NodePtr, bool> top = stack.back();
+    stack.pop_back();
+
+    NodePtr node = top.first;
+    if (!top.second) {
+      enter.push_back(flat.originalId.size());
+      stack.emplace_back(node, true);
+      for (auto it = node->children().rbegin(); it != node->children().rend(); ++it)
+        stack.emplace_back(*it, false);
+      continue;
+    }
+
+    const uint32 id = flat.originalId.size();
+    flatId[node->id()] = id;
+    flat.originalId.push_back(node->id());
+    flat.level[id] = node->level();
+    flat.first[id] = enter.back();
+    enter.pop_back();
+
+    flat.childOffset.push_back(flat.children.size());
+    for (NodePtr c : node->children()) {
+      flat.children.push_back(flatId[c->id()]);
+      flat.parent[flatId[c->id()]] = id;
+    }
+
+    flat.pixelOffset.push_back(flat.pixels.size());
+    flat.pixels.insert(flat.pixels.end(), node->cnps().begin(), node->cnps().end());
+  }
+  flat.childOffset.push_back(flat.children.size());
+  flat.pixelOffset.push_back(flat.pixels.size());
+  flat.parent[flat.root()] = flat.root();
+
+  return flat;
+}
+
+template<class ContourSet, class ValueType>
+std::vector<ContourSet> extractCountorsFlatTree(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const FlatTree<ValueType> &tree)
+{
+  using morphotree::uint32;
+  using morphotree::uint8;
+  using morphotree::Box;
+
+  std::vector<ContourSet> contours(tree.numberOfNodes());
+  std::vector<uint8> ncount(domain.numberOfPoints());
+
+  for (uint32 i = 0; i < tree.numberOfNodes(); i++) {
+    // Initialise contours of node "N"
+    ContourSet &Ncontour = contours[i];
+    for (uint32 k = tree.childOffset[i]; k < tree.childOffset[i+1]; k++) {
+      for (uint32 pidx : contours[tree.children[k]])
+        Ncontour.insert(pidx);
+    }
+
+    for (uint32 k = tree.pixelOffset[i]; k < tree.pixelOffset[i+1]; k++) {
+      const uint32 pidx = tree.pixels[k];
+      for (uint32 qidx : adj->neighbours(pidx)) {
+        if (qidx == Box::UndefinedIndex || f[pidx] > f[qidx])
+          ncount[pidx]++;
+        else if (f[pidx] < f[qidx]) {
+          ncount[qidx]--;
+
+          if (ncount[qidx] == 0)
+            Ncontour.erase(qidx);
+        }
+      }
+
+      if (ncount[pidx] > 0)
+        Ncontour.insert(pidx);
+    }
+  }
+
+  return contours;
+}
+
+template<class ValueType>
+ContourCounts computeContourCountsFlatTree(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const FlatTree<ValueType> &tree)
+{
+  using morphotree::uint32;
+  using morphotree::uint8;
+  using morphotree::Box;
+
+  ContourCounts counts;
+  counts.pixels.resize(tree.numberOfNodes(), 0);
+  counts.edges.resize(tree.numberOfNodes(), 0);
+  std::vector<uint8> ncount(domain.numberOfPoints());
+
+  for (uint32 i = 0; i < tree.numberOfNodes(); i++) {
+    uint32 Npixels = counts.pixels[i];
+    std::uint64_t Nedges = counts.edges[i];
+
+    for (uint32 k = tree.pixelOffset[i]; k < tree.pixelOffset[i+1]; k++) {
+      const uint32 pidx = tree.pixels[k];
+      for (uint32 qidx : adj->neighbours(pidx)) {
+        if (qidx == Box::UndefinedIndex || f[pidx] > f[qidx]) {
+          ncount[pidx]++;
+          Nedges++;
+        }
+        else if (f[pidx] < f[qidx]) {
+          ncount[qidx]--;
+          Nedges--;
+
+          if (ncount[qidx] == 0)
+            Npixels--;
+        }
+      }
+
+      if (ncount[pidx] > 0)
+        Npixels++;
+    }
+
+    counts.pixels[i] = Npixels;
+    counts.edges[i] = Nedges;
+    if (i != tree.root()) {
+      counts.pixels[tree.parent[i]] += Npixels;
+      counts.edges[tree.parent[i]] += Nedges;
+    }
+  }
+
+  return counts;
+}
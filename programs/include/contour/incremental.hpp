@@ -0,0 +1,162 @@
+#pragma once
+
+#include <morphotree/core/box.hpp>
+#include <morphotree/core/alias.hpp>
+#include <morphotree/adjacency/adjacency.hpp>
+#include <morphotree/tree/mtree.hpp>
+
+#include <memory>
+#include <vector>
+
+// Incremental contour extraction (the algorithm of the paper) with the 
+// contour of every node stored in a "ContourSet": std::unordered_set for the
+// hash map version and std::set for the red-black tree version.
+template<class ContourSet, class ValueType>
+std::vector<ContourSet> extractCountorsIncremental(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree);
+
+// Same, with every contour set built with a copy of "alloc" (e.g. a
+// PoolAllocator, see nodepool.hpp, for sets without a default allocator).
+template<class ContourSet, class ValueType>
+std::vector<ContourSet> extractCountorsIncremental(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree,
+  const typename ContourSet::allocator_type &alloc);
+
+// Phases of the extraction of one node, reported to a phase observer: merge
+// of the children, scan of the neighbours of the cnps (increments of their
+// lower-neighbour counts), decrements of the counts of the higher neighbours
+// (with the erasures) and insertions of the cnps.
+struct ExtractionPhase
+{
+  enum Phase { ChildMerge = 0, NeighbourScan, DecrementErase, Insert, NumberOfPhases };
+};
+
+// Same, with observer.endPhase(phase) called at the end of every phase of
+// every node (e.g. to read hardware counters, see perfcounters.hpp). The
+// three cnps phases are interleaved per pixel in the kernel, so they are only
+// told apart when PhaseObserver::SplitCnpsUpdate is true: the cnps are then
+// updated in three passes (the higher neighbours kept in a buffer between the
+// first two), which gives the same contours because a decrement only reaches
+// pixels of the descendants and an insertion only the cnps. Otherwise the
+// calls are outside the loops and the kernel is the one of the other overloads.
+template<class ContourSet, class ValueType, class PhaseObserver>
+std::vector<ContourSet> extractCountorsIncremental(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree,
+  const typename ContourSet::allocator_type &alloc,
+  PhaseObserver &observer);
+
+// =================== [IMPLEMENTATION] ==========================
+struct NoPhaseObserver
+{
+  static const bool SplitCnpsUpdate = false;
+  void endPhase(int) {}
+};
+
+template<class ContourSet, class ValueType>
+std::vector<ContourSet> extractCountorsIncremental(
+  const morphotree::Box &domain, 
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree)
+{
+  return extractCountorsIncremental<ContourSet>(domain, f, adj, tree,
+    typename ContourSet::allocator_type());
+}
+
+template<class ContourSet, class ValueType>
+std::vector<ContourSet> extractCountorsIncremental(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree,
+  const typename ContourSet::allocator_type &alloc)
+{
+  NoPhaseObserver observer;
+  return extractCountorsIncremental<ContourSet>(domain, f, adj, tree, alloc, observer);
+}
+
+template<class ContourSet, class ValueType, class PhaseObserver>
+std::vector<ContourSet> extractCountorsIncremental(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree,
+  const typename ContourSet::allocator_type &alloc,
+  PhaseObserver &observer)
+{
+  using MTree = morphotree::MorphologicalTree<ValueType>;
+  using morphotree::uint32;
+  using morphotree::uint8;
+  using morphotree::Box;
+  using NodePtr = typename MTree::NodePtr;
+
+  std::vector<ContourSet> contours(tree.numberOfNodes(), ContourSet(alloc));
+  std::vector<uint8> ncount(domain.numberOfPoints());
+  std::vector<uint32> higher;   // higher neighbours of the cnps (split update only)
+
+  tree.tranverse([&f, &contours, &ncount, &higher, &observer, adj](NodePtr node){
+    
+    // Initialise contours of node "N"
+    ContourSet &Ncontour = contours[node->id()];
+    for (NodePtr c : node->children()) {
+      for (uint32 pidx : contours[c->id()])
+        Ncontour.insert(pidx);
+    }
+    observer.endPhase(ExtractionPhase::ChildMerge);
+
+    if (PhaseObserver::SplitCnpsUpdate) {
+      higher.clear();
+      for (uint32 pidx : node->cnps()) {
+        for (uint32 qidx : adj->neighbours(pidx)) {
+          if (qidx == Box::UndefinedIndex || f[pidx] > f[qidx]) 
+            ncount[pidx]++;
+          else if (f[pidx] < f[qidx])
+            higher.push_back(qidx);
+        }
+      }
+      observer.endPhase(ExtractionPhase::NeighbourScan);
+
+      for (uint32 qidx : higher) {
+        ncount[qidx]--;
+
+        if (ncount[qidx] == 0) 
+          Ncontour.erase(qidx);
+      }
+      observer.endPhase(ExtractionPhase::DecrementErase);
+
+      for (uint32 pidx : node->cnps()) {
+        if (ncount[pidx] > 0)
+          Ncontour.insert(pidx);
+      }
+      observer.endPhase(ExtractionPhase::Insert);
+      return;
+    }
+
+    for (uint32 pidx : node->cnps()) {
+      for (uint32 qidx : adj->neighbours(pidx)) {
+        if (qidx == Box::UndefinedIndex || f[pidx] > f[qidx]) 
+          ncount[pidx]++;
+        else if (f[pidx] < f[qidx]) {
+          ncount[qidx]--;
+
+          if (ncount[qidx] == 0) 
+            Ncontour.erase(qidx);
+        }
+      }
+
+      if (ncount[pidx] > 0)
+        Ncontour.insert(pidx);
+    }
+  });
+  
+  return contours;
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+// Heap accounting through a replacement of the global operator new/delete.
+// The replacement is compiled in the translation unit which defines
+// CONTOUR_ALLOCATION_HOOK_IMPLEMENTATION before including this header (like
+// STB_IMAGE_IMPLEMENTATION, and without including the header before); in any
+// other program the counters stay at 0.
+//
+// Counting is off until startAllocationCounting() is called, but the hook is
+// active for every allocation of the program: each block gets a 16-byte
+// header (which also moves small blocks to a larger malloc size class) and
+// an atomic flag is read. Programs timing allocation-heavy code should not
+// define CONTOUR_ALLOCATION_HOOK_IMPLEMENTATION in the timed binary. Blocks
+// remember whether they were counted, so memory allocated before the start is
+// not subtracted on release.
+struct AllocationStats
+{
+  std::uint64_t allocations;   // calls to operator new
+  std::uint64_t bytes;         // bytes requested
+  std::uint64_t peakBytes;     // high-water mark of the live counted bytes
+};
+
+void startAllocationCounting();
+AllocationStats stopAllocationCounting();
+
+// Peak resident set size of the process in bytes (VmHWM). resetPeakRSS()
+// resets it to the current RSS where the kernel allows it (Linux >= 4.0);
+// otherwise the peak is the one of the whole process.
+std::uint64_t peakRSS();
+void resetPeakRSS();
+
+// =================== [IMPLEMENTATION] ==========================
+namespace contour_memory
+{
+  struct Counters
+  {
+    std::atomic<bool> enabled{false};
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> bytes{0};
+    std::atomic<std::int64_t> live{0};
+    std::atomic<std::int64_t> peak{0};
+  };
+
+  inline Counters &counters()
+  {
+    static Counters c;
+    return c;
+  }
+}
+
+inline void startAllocationCounting()
+{
+  contour_memory::Counters &c = contour_memory::counters();
+  c.allocations = 0;
+  c.bytes = 0;
+  c.live = 0;
+  c.peak = 0;
+  c.enabled = true;
+}
+
+inline AllocationStats stopAllocationCounting()
+{
+  contour_memory::Counters &c = contour_memory::counters();
+  c.enabled = false;
+  return AllocationStats{c.allocations, c.bytes, static_cast<std::uint64_t>(c.peak)};
+}
+
+inline std::uint64_t peakRSS()
+{
+#if defined(__linux__)
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmHWM:") == 0)
+      return std::stoull(line.substr(6)) * 1024;
+  }
+
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;
+#else
+  return 0;
+#endif
+}
+
+inline void resetPeakRSS()
+{
+#if defined(__linux__)
+  std::ofstream clearRefs("/proc/self/clear_refs");
+  clearRefs << "5";
+#endif
+}
+
+#if defined(CONTOUR_ALLOCATION_HOOK_IMPLEMENTATION)
+#include <cstdlib>
+#include <new>
+
+namespace contour_memory
+{
+  // Every block starts with a header (kept at the default new alignment)
+  // holding its size and whether it was counted.
+  struct alignas(alignof(std::max_align_t)) Header
+  {
+    std::size_t size;
+    bool counted;
+  };
+
+  inline void *allocate(std::size_t size)
+  {
+    Header *h = static_cast<Header*>(std::malloc(sizeof(Header) + size));
+    if (h == nullptr)
+      return nullptr;
+
+    Counters &c = counters();
+    h->size = size;
+    h->counted = c.enabled.load(std::memory_order_relaxed);
+    if (h->counted) {
+      c.allocations.fetch_add(1, std::memory_order_relaxed);
+      c.bytes.fetch_add(size, std::memory_order_relaxed);
+
+      std::int64_t live = c.live.fetch_add(size, std::memory_order_relaxed) + size;
+      std::int64_t peak = c.peak.load(std::memory_order_relaxed);
+      while (live > peak && !c.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+        ;
+    }
+
+    return h + 1;
+  }
+
+  inline void release(void *p)
+  {
+    if (p == nullptr)
+      return;
+
+    Header *h = static_cast<Header*>(p) - 1;
+    if (h->counted)
+      counters().live.fetch_sub(h->size, std::memory_order_relaxed);
+
+    std::free(h);
+  }
+}
+
+void *operator new(std::size_t size)
+{
+  void *p = contour_memory::allocate(size);
+  if (p == nullptr)
+    throw std::bad_alloc();
+  return p;
+}
+
+void *operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+  return contour_memory::allocate(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+  return contour_memory::allocate(size);
+}
+
+void operator delete(void *p) noexcept { contour_memory::release(p); }
+void operator delete[](void *p) noexcept { contour_memory::release(p); }
+void operator delete(void *p, std::size_t) noexcept { contour_memory::release(p); }
+void operator delete[](void *p, std::size_t) noexcept { contour_memory::release(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { contour_memory::release(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { contour_memory::release(p); }
+#endif
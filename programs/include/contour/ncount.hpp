@@ -0,0 +1,201 @@
+#pragma once
+
+#include <morphotree/core/box.hpp>
+#include <morphotree/core/alias.hpp>
+#include <morphotree/tree/mtree.hpp>
+
+#include "contour/padded.hpp"
+
+#include <array>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Initial value of "ncount" for every pixel: the number of neighbours which
+// are strictly darker or outside the domain. Interior pixels of uint8 images
+// are computed row by row with AVX2 (or SSE2) when the compiler enables it;
+// borders and other grey-level types use the scalar code.
+template<class AdjacencyType, class ValueType>
+std::vector<morphotree::uint8> computeLowerNeighbourCount(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f);
+
+// Incremental contour extraction in which the lower-neighbour counts come from
+// computeLowerNeighbourCount, so the traversal only applies the decrements.
+// The traversal is the one of extractCountorsPadded, which is the baseline
+// that isolates the gain of the precomputed counts.
+template<class AdjacencyType, class ContourSet, class ValueType>
+std::vector<ContourSet> extractCountorsPrecomputed(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  const morphotree::MorphologicalTree<ValueType> &tree);
+
+// =================== [IMPLEMENTATION] ==========================
+template<class AdjacencyType, class ValueType>
+morphotree::uint8 lowerNeighbourCount(const std::vector<ValueType> &f,
+  morphotree::int32 width, morphotree::int32 height,
+  morphotree::int32 x, morphotree::int32 y)
+{
+  using morphotree::int32;
+  using morphotree::uint8;
+  using Offsets = AdjacencyOffsets<AdjacencyType>;
+
+  const ValueType fp = f[y*width + x];
+  uint8 count = 0;
+  for (int k = 0; k < Offsets::Size; k++) {
+    const int32 qx = x + Offsets::dx(k);
+    const int32 qy = y + Offsets::dy(k);
+
+    if (qx < 0 || qy < 0 || qx >= width || qy >= height || f[qy*width + qx] < fp)
+      count++;
+  }
+
+  return count;
+}
+
+// Vectorised counts for "n" consecutive interior pixels. Returns how many of
+// them were computed; the generic version leaves all of them to the scalar code.
+template<class AdjacencyType, class ValueType>
+morphotree::uint32 lowerNeighbourCountRowSIMD(const ValueType *fp,
+  morphotree::uint8 *ncount, morphotree::uint32 n, const morphotree::int32 *off)
+{
+  return 0;
+}
+
+template<class AdjacencyType>
+morphotree::uint32 lowerNeighbourCountRowSIMD(const morphotree::uint8 *fp,
+  morphotree::uint8 *ncount, morphotree::uint32 n, const morphotree::int32 *off)
+{
+  using Offsets = AdjacencyOffsets<AdjacencyType>;
+
+  morphotree::uint32 i = 0;
+
+  // a pixel q is not lower than p when saturate(f[p] - f[q]) == 0, so the
+  // count is Size minus the number of such neighbours.
+#if defined(__AVX2__)
+  {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i size = _mm256_set1_epi8(Offsets::Size);
+    for (; i + 32 <= n; i += 32) {
+      const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(fp + i));
+      __m256i notLower = zero;
+      for (int k = 0; k < Offsets::Size; k++) {
+        const __m256i q = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(fp + i + off[k]));
+        notLower = _mm256_sub_epi8(notLower, _mm256_cmpeq_epi8(_mm256_subs_epu8(c, q), zero));
+      }
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(ncount + i),
+        _mm256_sub_epi8(size, notLower));
+    }
+  }
+#endif
+
+#if defined(__SSE2__)
+  {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i size = _mm_set1_epi8(Offsets::Size);
+    for (; i + 16 <= n; i += 16) {
+      const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(fp + i));
+      __m128i notLower = zero;
+      for (int k = 0; k < Offsets::Size; k++) {
+        const __m128i q = _mm_loadu_si128(reinterpret_cast<const __m128i*>(fp + i + off[k]));
+        notLower = _mm_sub_epi8(notLower, _mm_cmpeq_epi8(_mm_subs_epu8(c, q), zero));
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(ncount + i),
+        _mm_sub_epi8(size, notLower));
+    }
+  }
+#endif
+
+  return i;
+}
+
+template<class AdjacencyType, class ValueType>
+std::vector<morphotree::uint8> computeLowerNeighbourCount(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f)
+{
+  using morphotree::uint8;
+  using morphotree::uint32;
+  using morphotree::int32;
+  using Offsets = AdjacencyOffsets<AdjacencyType>;
+
+  const int32 width = domain.width();
+  const int32 height = domain.height();
+
+  std::array<int32, Offsets::Size> off;
+  for (int k = 0; k < Offsets::Size; k++)
+    off[k] = Offsets::dy(k) * width + Offsets::dx(k);
+
+  std::vector<uint8> ncount(domain.numberOfPoints());
+
+  for (int32 y = 0; y < height; y++) {
+    const uint32 row = y * width;
+    int32 x = 0;
+
+    // interior of the row: every neighbour is inside the domain
+    if (0 < y && y < height - 1 && width > 2) {
+      ncount[row] = lowerNeighbourCount<AdjacencyType>(f, width, height, 0, y);
+      x = 1 + lowerNeighbourCountRowSIMD<AdjacencyType>(f.data() + row + 1,
+        ncount.data() + row + 1, width - 2, off.data());
+    }
+
+    for (; x < width; x++)
+      ncount[row + x] = lowerNeighbourCount<AdjacencyType>(f, width, height, x, y);
+  }
+
+  return ncount;
+}
+
+template<class AdjacencyType, class ContourSet, class ValueType>
+std::vector<ContourSet> extractCountorsPrecomputed(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  const morphotree::MorphologicalTree<ValueType> &tree)
+{
+  using MTree = morphotree::MorphologicalTree<ValueType>;
+  using morphotree::uint32;
+  using morphotree::int32;
+  using morphotree::uint8;
+  using NodePtr = typename MTree::NodePtr;
+  using Offsets = AdjacencyOffsets<AdjacencyType>;
+
+  std::vector<uint8> ncount = computeLowerNeighbourCount<AdjacencyType>(domain, f);
+
+  PaddedImage<PaddedValue> fpad{domain, f, PaddedSentinel};
+  const std::array<int32, Offsets::Size> poff = fpad.template paddedOffsets<AdjacencyType>();
+  const std::array<int32, Offsets::Size> off = fpad.template offsets<AdjacencyType>();
+
+  std::vector<ContourSet> contours(tree.numberOfNodes());
+
+  tree.tranverse([&fpad, &poff, &off, &contours, &ncount](NodePtr node){
+
+    // Initialise contours of node "N"
+    ContourSet &Ncontour = contours[node->id()];
+    for (NodePtr c : node->children()) {
+      for (uint32 pidx : contours[c->id()])
+        Ncontour.insert(pidx);
+    }
+
+    for (uint32 pidx : node->cnps()) {
+      const uint32 ppidx = fpad.toPadded(pidx);
+      const PaddedValue fp = fpad[ppidx];
+
+      for (int k = 0; k < Offsets::Size; k++) {
+        if (fp < fpad[ppidx + poff[k]]) {
+          const uint32 qidx = pidx + off[k];
+          ncount[qidx]--;
+
+          if (ncount[qidx] == 0)
+            Ncontour.erase(qidx);
+        }
+      }
+
+      if (ncount[pidx] > 0)
+        Ncontour.insert(pidx);
+    }
+  });
+
+  return contours;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <morphotree/core/alias.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <set>
+#include <vector>
+
+// Memory of the node-based contour sets of one extraction. Blocks are carved
+// out of large chunks (monotonic) and grouped in size classes of 16 bytes: a
+// released block goes to the free list of its class and is reused by the next
+// allocation of the same class, so the erasures of the incremental algorithm
+// do not make the pool grow. Nothing is returned to the heap before the pool
+// is destroyed, when every chunk is released at once. Requests larger than
+// MaxPooledSize go to the global allocator.
+class NodePool
+{
+public:
+  static const std::size_t Alignment = 16;
+  static const std::size_t MaxPooledSize = 256;
+
+  explicit NodePool(std::size_t firstChunkSize = 64 * 1024);
+
+  NodePool(const NodePool &) = delete;
+  NodePool &operator=(const NodePool &) = delete;
+
+  void *allocate(std::size_t size);
+  void deallocate(void *p, std::size_t size);
+
+  // bytes obtained from the heap for the chunks
+  std::size_t reservedBytes() const { return reserved_; }
+
+private:
+  struct FreeBlock { FreeBlock *next; };
+
+  static std::size_t sizeClass(std::size_t size)
+  {
+    return size == 0 ? 1 : (size + Alignment - 1) / Alignment;
+  }
+  void newChunk(std::size_t minSize);
+
+private:
+  std::vector<std::unique_ptr<unsigned char[]>> chunks_;
+  unsigned char *cur_;
+  unsigned char *end_;
+  std::size_t nextChunkSize_;
+  std::size_t reserved_;
+  FreeBlock *free_[MaxPooledSize / Alignment + 1];
+};
+
+// C++14 allocator drawing from a NodePool. Copies (including the rebound
+// ones the containers make for their nodes) share the pool.
+template<class T>
+class PoolAllocator
+{
+public:
+  using value_type = T;
+
+  explicit PoolAllocator(NodePool &pool) : pool_{&pool} {}
+
+  template<class U>
+  PoolAllocator(const PoolAllocator<U> &other) : pool_{other.pool()} {}
+
+  T *allocate(std::size_t n) { return static_cast<T*>(pool_->allocate(n * sizeof(T))); }
+  void deallocate(T *p, std::size_t n) { pool_->deallocate(p, n * sizeof(T)); }
+
+  NodePool *pool() const { return pool_; }
+
+private:
+  NodePool *pool_;
+};
+
+template<class T, class U>
+bool operator==(const PoolAllocator<T> &a, const PoolAllocator<U> &b) { return a.pool() == b.pool(); }
+
+template<class T, class U>
+bool operator!=(const PoolAllocator<T> &a, const PoolAllocator<U> &b) { return a.pool() != b.pool(); }
+
+// red-black tree contour whose nodes live in a NodePool
+using PooledSet = std::set<morphotree::uint32, std::less<morphotree::uint32>,
+  PoolAllocator<morphotree::uint32>>;
+
+// =================== [IMPLEMENTATION] ==========================
+inline NodePool::NodePool(std::size_t firstChunkSize)
+  : cur_{nullptr}, end_{nullptr}, nextChunkSize_{firstChunkSize}, reserved_{0}
+{
+  for (FreeBlock *&head : free_)
+    head = nullptr;
+}
+
+inline void NodePool::newChunk(std::size_t minSize)
+{
+  std::size_t size = std::max(nextChunkSize_, minSize);
+  chunks_.emplace_back(new unsigned char[size + Alignment]);
+
+  // operator new[] only guarantees the alignment of the fundamental types
+  std::size_t misalignment = reinterpret_cast<std::size_t>(chunks_.back().get()) % Alignment;
+  cur_ = chunks_.back().get() + (misalignment == 0 ? 0 : Alignment - misalignment);
+  end_ = cur_ + size;
+
+  reserved_ += size + Alignment;
+  nextChunkSize_ = std::min<std::size_t>(2 * nextChunkSize_, 16 * 1024 * 1024);
+}
+
+inline void *NodePool::allocate(std::size_t size)
+{
+  if (size > MaxPooledSize)
+    return ::operator new(size);
+
+  const std::size_t c = sizeClass(size);
+  if (free_[c] != nullptr) {
+    FreeBlock *block = free_[c];
+    free_[c] = block->next;
+    return block;
+  }
+
+  const std::size_t bytes = c * Alignment;
+  if (static_cast<std::size_t>(end_ - cur_) < bytes)
+    newChunk(bytes);
+
+  void *p = cur_;
+  cur_ += bytes;
+  return p;
+}
+
+inline void NodePool::deallocate(void *p, std::size_t size)
+{
+  if (size > MaxPooledSize) {
+    ::operator delete(p);
+    return;
+  }
+
+  const std::size_t c = sizeClass(size);
+  FreeBlock *block = static_cast<FreeBlock*>(p);
+  block->next = free_[c];
+  free_[c] = block;
+}
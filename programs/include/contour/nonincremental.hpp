@@ -4,9 +4,44 @@
 #include <morphotree/core/alias.hpp>
 #include <morphotree/adjacency/adjacency.hpp>
 
+#include <morphotree/tree/mtree.hpp>
 
+#include "contour/padded.hpp"
+#include "contour/workstealing.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <unordered_set>
 #include <vector>
 
+// Contours of every node stored in one arena (pixel buffer) per thread. The 
+// contour of a node is the slice [begin, end) of the arena of the thread 
+// which computed it.
+struct ContourArena
+{
+  using uint32 = morphotree::uint32;
+
+  struct Slice
+  {
+    uint32 arena;
+    uint32 begin;
+    uint32 end;
+  };
+
+  std::vector<std::vector<uint32>> arenas;
+  std::vector<Slice> slices;
+
+  const uint32 *begin(uint32 nodeId) const 
+  { 
+    return arenas[slices[nodeId].arena].data() + slices[nodeId].begin; 
+  }
+
+  const uint32 *end(uint32 nodeId) const 
+  { 
+    return arenas[slices[nodeId].arena].data() + slices[nodeId].end; 
+  }
+};
+
 std::vector<bool> computeContourNonIncremental(std::shared_ptr<morphotree::Adjacency> adj,
   morphotree::Box &domain, 
   const std::vector<bool> &bimg)
@@ -26,4 +61,156 @@ std::vector<bool> computeContourNonIncremental(std::shared_ptr<morphotree::Adjac
   }
   
   return contour;
-}
\ No newline at end of file
+}
+
+// Same as computeContourNonIncremental with compile-time neighbour offsets
+// over a padded binary image (AdjacencyType is InfAdjacency4C or InfAdjacency8C).
+template<class AdjacencyType>
+std::vector<bool> computeContourNonIncrementalPadded(const morphotree::Box &domain, 
+  const std::vector<bool> &bimg)
+{
+  using morphotree::uint8;
+  using morphotree::uint32;
+  using morphotree::int32;
+  using Offsets = AdjacencyOffsets<AdjacencyType>;
+
+  PaddedImage<uint8> bpad{domain, bimg, 0};
+  const std::array<int32, Offsets::Size> poff = bpad.template paddedOffsets<AdjacencyType>();
+
+  std::vector<bool> contour(domain.numberOfPoints(), false);
+
+  for (uint32 pidx = 0; pidx < domain.numberOfPoints(); pidx++) {
+    if (!bimg[pidx])
+      continue;
+
+    const uint32 ppidx = bpad.toPadded(pidx);
+    for (int k = 0; k < Offsets::Size; k++) {
+      if (!bpad[ppidx + poff[k]]) {
+        contour[pidx] = true;
+        break;
+      }
+    }
+  }
+
+  return contour;
+}
+
+// Non-incremental contour extraction: every node is reconstructed and its
+// pixels with a neighbour (in "adj") lower than the node level, or outside 
+// the domain, are its contour.
+template<class ValueType>
+std::vector<std::unordered_set<morphotree::uint32>> extractCountorsNonIncremental(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree)
+{
+  using MTree = morphotree::MorphologicalTree<ValueType>;
+  using morphotree::uint32;
+  using morphotree::I32Point;
+  using NodePtr = typename MTree::NodePtr;
+
+  std::vector<std::unordered_set<uint32>> contours(tree.numberOfNodes());
+
+  tree.traverseByLevel([&contours, &domain, &adj, &f](NodePtr node){
+    std::vector<uint32> bnode = node->reconstruct();
+    std::unordered_set<uint32> Ncountor;
+    for (uint32 pidx : bnode) {
+      for (uint32 qidx : adj->neighbours(pidx)) {
+        I32Point q = domain.indexToPoint(qidx);
+        if(!domain.contains(q) || f[qidx] < node->level()) {
+          Ncountor.insert(pidx);
+        }
+      }
+    }
+
+    contours[node->id()] = Ncountor;
+  });
+
+  return contours;
+}
+
+// Multithreaded non-incremental contour extraction. Nodes are independent, so
+// chunks of "nodesPerTask" nodes are scheduled on a work-stealing pool. Each
+// thread reuses its own buffers to reconstruct the nodes and appends their 
+// contours to its own arena, so no set is built and nothing is shared.
+template<class AdjacencyType, class ValueType>
+ContourArena extractCountorsNonIncrementalParallel(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  const morphotree::MorphologicalTree<ValueType> &tree,
+  WorkStealingPool &pool,
+  morphotree::uint32 nodesPerTask = 64)
+{
+  using MTree = morphotree::MorphologicalTree<ValueType>;
+  using morphotree::uint32;
+  using morphotree::int32;
+  using NodePtr = typename MTree::NodePtr;
+  using Node = typename NodePtr::element_type;
+  using Offsets = AdjacencyOffsets<AdjacencyType>;
+
+  struct Scratch
+  {
+    std::vector<Node*> stack;
+    std::vector<uint32> pixels;
+  };
+
+  PaddedImage<PaddedValue> fpad{domain, f, PaddedSentinel};
+  const std::array<int32, Offsets::Size> poff = fpad.template paddedOffsets<AdjacencyType>();
+
+  // workers plus the thread waiting on the pool, which also runs tasks
+  const uint32 nthreads = pool.size() + 1;
+  std::vector<Scratch> scratch(nthreads);
+
+  ContourArena result;
+  result.arenas.resize(nthreads);
+  result.slices.resize(tree.numberOfNodes());
+
+  std::vector<NodePtr> nodes;
+  nodes.reserve(tree.numberOfNodes());
+  tree.traverseByLevel([&nodes](NodePtr node) { nodes.push_back(node); });
+
+  WorkStealingPool::TaskGroup group;
+  for (uint32 first = 0; first < nodes.size(); first += nodesPerTask) {
+    const uint32 last = std::min<uint32>(first + nodesPerTask, nodes.size());
+
+    pool.submit(group, [&, first, last]() {
+      const uint32 self = pool.currentWorker();
+      Scratch &s = scratch[self];
+      std::vector<uint32> &arena = result.arenas[self];
+
+      for (uint32 i = first; i < last; i++) {
+        Node *node = nodes[i].get();
+        const PaddedValue level = static_cast<PaddedValue>(node->level());
+
+        // reconstruct the node into the reusable pixel buffer
+        s.pixels.clear();
+        s.stack.assign(1, node);
+        while (!s.stack.empty()) {
+          Node *n = s.stack.back();
+          s.stack.pop_back();
+          s.pixels.insert(s.pixels.end(), n->cnps().begin(), n->cnps().end());
+          for (const NodePtr &c : n->children())
+            s.stack.push_back(c.get());
+        }
+
+        ContourArena::Slice &slice = result.slices[node->id()];
+        slice.arena = self;
+        slice.begin = arena.size();
+        for (uint32 pidx : s.pixels) {
+          const uint32 ppidx = fpad.toPadded(pidx);
+          for (int k = 0; k < Offsets::Size; k++) {
+            if (fpad[ppidx + poff[k]] < level) {
+              arena.push_back(pidx);
+              break;
+            }
+          }
+        }
+        slice.end = arena.size();
+      }
+    });
+  }
+  pool.wait(group);
+
+  return result;
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <morphotree/core/box.hpp>
+#include <morphotree/core/alias.hpp>
+#include <morphotree/adjacency/adjacency4c.hpp>
+#include <morphotree/adjacency/adjacency8c.hpp>
+#include <morphotree/tree/mtree.hpp>
+
+#include <array>
+#include <limits>
+#include <vector>
+#include <unordered_set>
+
+// Compile-time neighbour offsets of the contour adjacencies. Only
+// InfAdjacency4C and InfAdjacency8C are specialised.
+template<class AdjacencyType>
+struct AdjacencyOffsets;
+
+template<>
+struct AdjacencyOffsets<morphotree::InfAdjacency4C>
+{
+  static constexpr int Size = 4;
+
+  static constexpr int dx(int k) { return k == 0 ? -1 : (k == 2 ? 1 : 0); }
+  static constexpr int dy(int k) { return k == 1 ? -1 : (k == 3 ? 1 : 0); }
+};
+
+template<>
+struct AdjacencyOffsets<morphotree::InfAdjacency8C>
+{
+  static constexpr int Size = 8;
+
+  static constexpr int dx(int k) { return k == 0 || k == 3 || k == 5 ? -1 :
+    (k == 2 || k == 4 || k == 7 ? 1 : 0); }
+  static constexpr int dy(int k) { return k < 3 ? -1 : (k > 4 ? 1 : 0); }
+};
+
+// Copy of an image with a one pixel border filled with a sentinel value, so
+// that every neighbour of a domain pixel can be read without bounds checks.
+// Indices in the padded image are called "padded indices" (ppidx).
+template<class T>
+class PaddedImage
+{
+public:
+  using uint32 = morphotree::uint32;
+  using int32 = morphotree::int32;
+
+  template<class ValueType>
+  PaddedImage(const morphotree::Box &domain, const std::vector<ValueType> &f,
+    T sentinel);
+
+  uint32 toPadded(uint32 pidx) const { return pidx + 2*(pidx / width_) + pwidth_ + 1; }
+  const T &operator[](uint32 ppidx) const { return data_[ppidx]; }
+
+  // Offsets of the neighbours in the padded image.
+  template<class AdjacencyType>
+  std::array<int32, AdjacencyOffsets<AdjacencyType>::Size> paddedOffsets() const;
+
+  // Offsets of the neighbours in the original image (valid only for
+  // neighbours inside the domain).
+  template<class AdjacencyType>
+  std::array<int32, AdjacencyOffsets<AdjacencyType>::Size> offsets() const;
+
+private:
+  uint32 width_;
+  uint32 pwidth_;
+  std::vector<T> data_;
+};
+
+// Grey-level type of a padded max-tree image. Its sentinel is lower than
+// any grey-level, which is how out-of-domain neighbours behave in the
+// incremental algorithm.
+using PaddedValue = morphotree::int32;
+static const PaddedValue PaddedSentinel = std::numeric_limits<PaddedValue>::min();
+
+// Incremental contour extraction (same as extractCountorsHashMap) over a
+// padded image. The inner loop has no virtual calls, no allocation of
+// neighbour lists and no domain checks.
+template<class AdjacencyType, class ContourSet, class ValueType>
+std::vector<ContourSet> extractCountorsPadded(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  const morphotree::MorphologicalTree<ValueType> &tree);
+
+// Non-incremental contour extraction (same as perf_non_incr_contour) over a
+// padded image.
+template<class AdjacencyType, class ValueType>
+std::vector<std::unordered_set<morphotree::uint32>> extractCountorsNonIncrementalPadded(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  const morphotree::MorphologicalTree<ValueType> &tree);
+
+// =================== [IMPLEMENTATION] ==========================
+template<class T>
+template<class ValueType>
+PaddedImage<T>::PaddedImage(const morphotree::Box &domain,
+  const std::vector<ValueType> &f, T sentinel)
+  : width_{domain.width()}, pwidth_{domain.width() + 2},
+    data_((domain.width() + 2) * (domain.height() + 2), sentinel)
+{
+  for (uint32 pidx = 0; pidx < domain.numberOfPoints(); pidx++)
+    data_[toPadded(pidx)] = static_cast<T>(f[pidx]);
+}
+
+template<class T>
+template<class AdjacencyType>
+std::array<morphotree::int32, AdjacencyOffsets<AdjacencyType>::Size>
+  PaddedImage<T>::paddedOffsets() const
+{
+  using Offsets = AdjacencyOffsets<AdjacencyType>;
+
+  std::array<int32, Offsets::Size> poff;
+  for (int k = 0; k < Offsets::Size; k++)
+    poff[k] = Offsets::dy(k) * static_cast<int32>(pwidth_) + Offsets::dx(k);
+
+  return poff;
+}
+
+template<class T>
+template<class AdjacencyType>
+std::array<morphotree::int32, AdjacencyOffsets<AdjacencyType>::Size>
+  PaddedImage<T>::offsets() const
+{
+  using Offsets = AdjacencyOffsets<AdjacencyType>;
+
+  std::array<int32, Offsets::Size> off;
+  for (int k = 0; k < Offsets::Size; k++)
+    off[k] = Offsets::dy(k) * static_cast<int32>(width_) + Offsets::dx(k);
+
+  return off;
+}
+
+template<class AdjacencyType, class ContourSet, class ValueType>
+std::vector<ContourSet> extractCountorsPadded(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  const morphotree::MorphologicalTree<ValueType> &tree)
+{
+  using MTree = morphotree::MorphologicalTree<ValueType>;
+  using morphotree::uint32;
+  using morphotree::int32;
+  using morphotree::uint8;
+  using NodePtr = typename MTree::NodePtr;
+  using Offsets = AdjacencyOffsets<AdjacencyType>;
+
+  PaddedImage<PaddedValue> fpad{domain, f, PaddedSentinel};
+  const std::array<int32, Offsets::Size> poff = fpad.template paddedOffsets<AdjacencyType>();
+  const std::array<int32, Offsets::Size> off = fpad.template offsets<AdjacencyType>();
+
+  std::vector<ContourSet> contours(tree.numberOfNodes());
+  std::vector<uint8> ncount(domain.numberOfPoints());
+
+  tree.tranverse([&fpad, &poff, &off, &contours, &ncount](NodePtr node){
+
+    // Initialise contours of node "N"
+    ContourSet &Ncontour = contours[node->id()];
+    for (NodePtr c : node->children()) {
+      for (uint32 pidx : contours[c->id()])
+        Ncontour.insert(pidx);
+    }
+
+    for (uint32 pidx : node->cnps()) {
+      const uint32 ppidx = fpad.toPadded(pidx);
+      const PaddedValue fp = fpad[ppidx];
+
+      for (int k = 0; k < Offsets::Size; k++) {
+        const PaddedValue fq = fpad[ppidx + poff[k]];
+        if (fp > fq)
+          ncount[pidx]++;
+        else if (fp < fq) {
+          const uint32 qidx = pidx + off[k];
+          ncount[qidx]--;
+
+          if (ncount[qidx] == 0)
+            Ncontour.erase(qidx);
+        }
+      }
+
+      if (ncount[pidx] > 0)
+        Ncontour.insert(pidx);
+    }
+  });
+
+  return contours;
+}
+
+template<class AdjacencyType, class ValueType>
+std::vector<std::unordered_set<morphotree::uint32>> extractCountorsNonIncrementalPadded(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  const morphotree::MorphologicalTree<ValueType> &tree)
+{
+  using MTree = morphotree::MorphologicalTree<ValueType>;
+  using morphotree::uint32;
+  using morphotree::int32;
+  using NodePtr = typename MTree::NodePtr;
+  using Offsets = AdjacencyOffsets<AdjacencyType>;
+
+  PaddedImage<PaddedValue> fpad{domain, f, PaddedSentinel};
+  const std::array<int32, Offsets::Size> poff = fpad.template paddedOffsets<AdjacencyType>();
+
+  std::vector<std::unordered_set<uint32>> contours(tree.numberOfNodes());
+
+  tree.traverseByLevel([&contours, &fpad, &poff](NodePtr node){
+    const PaddedValue level = static_cast<PaddedValue>(node->level());
+    std::unordered_set<uint32> &Ncountor = contours[node->id()];
+
+    for (uint32 pidx : node->reconstruct()) {
+      const uint32 ppidx = fpad.toPadded(pidx);
+      for (int k = 0; k < Offsets::Size; k++) {
+        if (fpad[ppidx + poff[k]] < level) {
+          Ncountor.insert(pidx);
+          break;
+        }
+      }
+    }
+  });
+
+  return contours;
+}
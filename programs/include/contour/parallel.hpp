@@ -0,0 +1,186 @@
+#pragma once
+
+#include <morphotree/core/box.hpp>
+#include <morphotree/core/alias.hpp>
+#include <morphotree/adjacency/adjacency.hpp>
+#include <morphotree/tree/mtree.hpp>
+
+#include "contour/workstealing.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <vector>
+
+// Union of the contours of the children of "node" without the pixels flagged
+// in "erased", computed as a tree-shaped parallel reduction: the children are
+// split into one chunk per thread, each chunk is merged into a partial set and
+// the partial sets are combined pairwise (the smaller into the larger).
+template<class ContourSet, class NodePtr>
+ContourSet reduceChildrenContours(const std::vector<ContourSet> &contours,
+  NodePtr node, const std::vector<morphotree::uint8> &erased, WorkStealingPool &pool)
+{
+  using morphotree::uint32;
+
+  const std::vector<NodePtr> &children = node->children();
+  const uint32 nparts = std::max<uint32>(1, 
+    std::min<uint32>(children.size(), pool.size()));
+  std::vector<ContourSet> partials(nparts);
+
+  WorkStealingPool::TaskGroup group;
+  for (uint32 i = 0; i < nparts; i++) {
+    pool.submit(group, [&contours, &children, &erased, &partials, nparts, i]() {
+      ContourSet &partial = partials[i];
+      for (uint32 c = i; c < children.size(); c += nparts) {
+        for (uint32 pidx : contours[children[c]->id()]) {
+          if (!erased[pidx])
+            partial.insert(pidx);
+        }
+      }
+    });
+  }
+  pool.wait(group);
+
+  for (uint32 stride = 1; stride < nparts; stride *= 2) {
+    WorkStealingPool::TaskGroup round;
+    for (uint32 i = 0; i + stride < nparts; i += 2*stride) {
+      pool.submit(round, [&partials, i, stride]() {
+        ContourSet &a = partials[i];
+        ContourSet &b = partials[i + stride];
+        if (a.size() < b.size())
+          a.swap(b);
+        a.insert(b.begin(), b.end());
+        ContourSet().swap(b);
+      });
+    }
+    pool.wait(round);
+  }
+
+  return std::move(partials[0]);
+}
+
+// Subtree-parallel incremental contour extraction. Disjoint subtrees share no
+// contour state and the ncount updates of a node only touch pixels of its own
+// subtree, so the leaves are scheduled as tasks on a work-stealing pool and
+// each node is processed by the task that finishes its last child.
+//
+// Nodes with more than "wideThreshold" children merge their children with
+// reduceChildrenContours. Their cnps are scanned first, so the pixels whose
+// ncount drops to zero are filtered out of the partial sets.
+//
+// The result is identical to the sequential extraction as long as the contour
+// adjacency is contained in the tree adjacency (e.g. 4-connected contours on
+// 4- or 8-connected trees).
+template<class ContourSet, class ValueType>
+std::vector<ContourSet> extractCountorsParallel(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree,
+  WorkStealingPool &pool,
+  morphotree::uint32 wideThreshold = std::numeric_limits<morphotree::uint32>::max(),
+  morphotree::uint32 leavesPerTask = 256)
+{
+  using MTree = morphotree::MorphologicalTree<ValueType>;
+  using morphotree::uint32;
+  using morphotree::uint8;
+  using morphotree::Box;
+  using NodePtr = typename MTree::NodePtr;
+
+  std::vector<ContourSet> contours(tree.numberOfNodes());
+  std::vector<uint8> ncount(domain.numberOfPoints());
+  std::vector<std::atomic<uint32>> pendingChildren(tree.numberOfNodes());
+  std::vector<NodePtr> leaves;
+
+  tree.tranverse([&pendingChildren, &leaves](NodePtr node) {
+    pendingChildren[node->id()] = node->children().size();
+    if (node->children().empty())
+      leaves.push_back(node);
+  });
+
+  std::vector<uint8> erased(domain.numberOfPoints(), 0);
+
+  auto processWideNode = [&f, &contours, &ncount, &erased, &pool, adj](NodePtr node) {
+    std::vector<uint32> added;
+    std::vector<uint32> removed;
+
+    for (uint32 pidx : node->cnps()) {
+      for (uint32 qidx : adj->neighbours(pidx)) {
+        if (qidx == Box::UndefinedIndex || f[pidx] > f[qidx])
+          ncount[pidx]++;
+        else if (f[pidx] < f[qidx]) {
+          ncount[qidx]--;
+
+          if (ncount[qidx] == 0) {
+            erased[qidx] = 1;
+            removed.push_back(qidx);
+          }
+        }
+      }
+
+      if (ncount[pidx] > 0)
+        added.push_back(pidx);
+    }
+
+    ContourSet &Ncontour = contours[node->id()];
+    Ncontour = reduceChildrenContours(contours, node, erased, pool);
+    Ncontour.insert(added.begin(), added.end());
+
+    for (uint32 qidx : removed)
+      erased[qidx] = 0;
+  };
+
+  auto processNode = [&f, &contours, &ncount, &processWideNode, wideThreshold, adj](NodePtr node) {
+    if (node->children().size() > wideThreshold) {
+      processWideNode(node);
+      return;
+    }
+
+    // Initialise contours of node "N"
+    ContourSet &Ncontour = contours[node->id()];
+    for (NodePtr c : node->children()) {
+      for (uint32 pidx : contours[c->id()])
+        Ncontour.insert(pidx);
+    }
+
+    for (uint32 pidx : node->cnps()) {
+      for (uint32 qidx : adj->neighbours(pidx)) {
+        if (qidx == Box::UndefinedIndex || f[pidx] > f[qidx])
+          ncount[pidx]++;
+        else if (f[pidx] < f[qidx]) {
+          ncount[qidx]--;
+
+          if (ncount[qidx] == 0)
+            Ncontour.erase(qidx);
+        }
+      }
+
+      if (ncount[pidx] > 0)
+        Ncontour.insert(pidx);
+    }
+  };
+
+  WorkStealingPool::TaskGroup group;
+  for (uint32 begin = 0; begin < leaves.size(); begin += leavesPerTask) {
+    uint32 end = std::min<uint32>(begin + leavesPerTask, leaves.size());
+
+    pool.submit(group, [&leaves, &pendingChildren, &processNode, begin, end]() {
+      for (uint32 i = begin; i < end; i++) {
+        // process the leaf and then every ancestor whose last child it completes
+        NodePtr node = leaves[i];
+        while (node != nullptr) {
+          processNode(node);
+
+          NodePtr parent = node->parent();
+          if (parent == nullptr || --pendingChildren[parent->id()] > 0)
+            break;
+          node = parent;
+        }
+      }
+    });
+  }
+  pool.wait(group);
+
+  return contours;
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include "contour/incremental.hpp"
+
+#include <morphotree/core/box.hpp>
+#include <morphotree/core/alias.hpp>
+#include <morphotree/adjacency/adjacency.hpp>
+#include <morphotree/tree/mtree.hpp>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware counters of the calling thread (user space only) read through
+// perf_event_open as one group, so all of them cover the same instructions.
+// Counters the kernel or the CPU does not provide are left out and read as 0;
+// available() is false when none could be opened (e.g. non-Linux systems or
+// perf_event_paranoid too strict).
+class PerfCounters
+{
+public:
+  enum Counter { Cycles = 0, Instructions, L1DMisses, LLCMisses, BranchMisses, NumberOfCounters };
+  using Values = std::array<std::uint64_t, NumberOfCounters>;
+
+  PerfCounters();
+  ~PerfCounters();
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  bool available() const { return leader_ >= 0; }
+
+  void start();
+  void stop();
+
+  // Current (cumulative since start) value of every counter.
+  Values read() const;
+
+  static const char *name(int counter);
+
+private:
+  int leader_;
+  std::array<int, NumberOfCounters> fds_;
+  std::array<int, NumberOfCounters> slot_;   // position in the group read, -1 if closed
+  int opened_;
+};
+
+// Counter totals of the phases of the incremental extraction (see
+// ExtractionPhase in incremental.hpp).
+struct PhaseCounters
+{
+  enum Phase { ChildMerge = ExtractionPhase::ChildMerge, 
+    NeighbourScan = ExtractionPhase::NeighbourScan, 
+    DecrementErase = ExtractionPhase::DecrementErase, Insert = ExtractionPhase::Insert,
+    NumberOfPhases = ExtractionPhase::NumberOfPhases };
+
+  std::array<PerfCounters::Values, NumberOfPhases> values{};
+  bool available = false;
+
+  static const char *name(int phase);
+};
+
+// extractCountorsIncremental with the counters read at the end of the phases
+// of every node (merge of the children, neighbour scan, decrements/erasures
+// and insertions), through its phase observer. The cnps loop of the timed
+// extraction is split into one pass per phase for this (see ExtractionPhase),
+// so the totals add up to slightly more than the fused loop costs.
+template<class ContourSet, class ValueType>
+std::vector<ContourSet> extractCountorsIncrementalProfiled(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree,
+  PhaseCounters &counters);
+
+// =================== [IMPLEMENTATION] ==========================
+#if defined(__linux__)
+inline PerfCounters::PerfCounters()
+  : leader_{-1}, opened_{0}
+{
+  fds_.fill(-1);
+  slot_.fill(-1);
+
+  const std::uint32_t types[NumberOfCounters] = {
+    PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE,
+    PERF_TYPE_HARDWARE };
+  const std::uint64_t configs[NumberOfCounters] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+      | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+    PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+      | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+    PERF_COUNT_HW_BRANCH_MISSES };
+
+  for (int c = 0; c < NumberOfCounters; c++) {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = types[c];
+    attr.config = configs[c];
+    attr.disabled = leader_ < 0 ? 1 : 0;   // the group is enabled through its leader
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+
+    int fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, leader_, 0));
+    if (fd < 0)
+      continue;
+
+    if (leader_ < 0)
+      leader_ = fd;
+    fds_[c] = fd;
+    slot_[c] = opened_++;
+  }
+}
+
+inline PerfCounters::~PerfCounters()
+{
+  for (int fd : fds_) {
+    if (fd >= 0)
+      close(fd);
+  }
+}
+
+inline void PerfCounters::start()
+{
+  if (!available())
+    return;
+
+  ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+inline void PerfCounters::stop()
+{
+  if (available())
+    ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+}
+
+inline PerfCounters::Values PerfCounters::read() const
+{
+  Values values{};
+  if (!available())
+    return values;
+
+  // PERF_FORMAT_GROUP layout: number of counters followed by their values
+  std::uint64_t buffer[1 + NumberOfCounters] = {};
+  if (::read(leader_, buffer, sizeof(buffer)) <= 0)
+    return values;
+
+  for (int c = 0; c < NumberOfCounters; c++) {
+    if (slot_[c] >= 0)
+      values[c] = buffer[1 + slot_[c]];
+  }
+
+  return values;
+}
+#else
+inline PerfCounters::PerfCounters() : leader_{-1}, opened_{0} { fds_.fill(-1); slot_.fill(-1); }
+inline PerfCounters::~PerfCounters() {}
+inline void PerfCounters::start() {}
+inline void PerfCounters::stop() {}
+inline PerfCounters::Values PerfCounters::read() const { return Values{}; }
+#endif
+
+inline const char *PerfCounters::name(int counter)
+{
+  static const char *names[NumberOfCounters] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses" };
+  return names[counter];
+}
+
+inline const char *PhaseCounters::name(int phase)
+{
+  static const char *names[NumberOfPhases] = {
+    "child_merge", "neighbour_scan", "decrement_erase", "insert" };
+  return names[phase];
+}
+
+// Phase observer adding the counters of every phase to "counters".
+class PhaseCounterObserver
+{
+public:
+  static const bool SplitCnpsUpdate = true;
+
+  PhaseCounterObserver(const PerfCounters &pmu, PhaseCounters &counters)
+    : pmu_(pmu), counters_(counters), last_(pmu.read())
+  {}
+
+  void endPhase(int phase)
+  {
+    const PerfCounters::Values now = pmu_.read();
+    for (int c = 0; c < PerfCounters::NumberOfCounters; c++)
+      counters_.values[phase][c] += now[c] - last_[c];
+    last_ = now;
+  }
+
+private:
+  const PerfCounters &pmu_;
+  PhaseCounters &counters_;
+  PerfCounters::Values last_;
+};
+
+template<class ContourSet, class ValueType>
+std::vector<ContourSet> extractCountorsIncrementalProfiled(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree,
+  PhaseCounters &counters)
+{
+  PerfCounters pmu;
+  counters = PhaseCounters{};
+  counters.available = pmu.available();
+
+  pmu.start();
+  PhaseCounterObserver observer(pmu, counters);
+  std::vector<ContourSet> contours = extractCountorsIncremental<ContourSet>(domain, f, adj, 
+    tree, typename ContourSet::allocator_type(), observer);
+  pmu.stop();
+
+  return contours;
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <morphotree/core/box.hpp>
+#include <morphotree/core/alias.hpp>
+#include <morphotree/adjacency/adjacency.hpp>
+#include <morphotree/tree/mtree.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Contours of the nodes "nodeIds" only (result[i] is the contour of node
+// nodeIds[i]). The contour of a node depends on its subtree only, so the
+// incremental algorithm is run on the subtrees of the requested nodes and
+// every other node of the tree is skipped. Inside a subtree the sets are
+// merged small-to-large and consumed by the parents, so only the requested
+// contours are kept.
+//
+// The contour adjacency must be contained in the tree adjacency (as for the
+// subtree-parallel extraction): otherwise the updates of one subtree would
+// reach pixels of another one.
+template<class ContourSet, class ValueType>
+std::vector<ContourSet> extractCountorsOfNodes(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree,
+  const std::vector<morphotree::uint32> &nodeIds);
+
+// Ids of the nodes with minLevel <= level <= maxLevel.
+template<class ValueType>
+std::vector<morphotree::uint32> nodesInLevelBand(
+  const morphotree::MorphologicalTree<ValueType> &tree,
+  ValueType minLevel, ValueType maxLevel);
+
+// =================== [IMPLEMENTATION] ==========================
+template<class ContourSet, class ValueType>
+std::vector<ContourSet> extractCountorsOfNodes(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree,
+  const std::vector<morphotree::uint32> &nodeIds)
+{
+  using MTree = morphotree::MorphologicalTree<ValueType>;
+  using morphotree::uint32;
+  using morphotree::uint8;
+  using morphotree::Box;
+  using NodePtr = typename MTree::NodePtr;
+
+  static const uint32 NotRequested = 0xFFFFFFFF;
+
+  // position of every requested node in the result
+  std::vector<uint32> slot(tree.numberOfNodes(), NotRequested);
+  for (uint32 i = 0; i < nodeIds.size(); i++)
+    slot[nodeIds[i]] = i;
+
+  // subtrees to visit: requested nodes without a requested ancestor. Whether
+  // a node has a requested ancestor is kept for every node met on the way
+  // up, so each ancestor is only walked once.
+  enum : uint8 { Unknown, Covered, Uncovered };
+  std::vector<uint8> covered(tree.numberOfNodes(), Unknown);
+  std::vector<NodePtr> roots;
+  std::vector<bool> isRoot(tree.numberOfNodes(), false);
+  std::vector<NodePtr> path;
+  for (uint32 id : nodeIds) {
+    NodePtr node = tree.node(id);
+    NodePtr ancestor = node->parent();
+    path.clear();
+    while (ancestor != nullptr && slot[ancestor->id()] == NotRequested 
+           && covered[ancestor->id()] == Unknown) {
+      path.push_back(ancestor);
+      ancestor = ancestor->parent();
+    }
+
+    uint8 state = Uncovered;
+    if (ancestor != nullptr)
+      state = slot[ancestor->id()] != NotRequested ? static_cast<uint8>(Covered) : covered[ancestor->id()];
+    for (NodePtr a : path)
+      covered[a->id()] = state;
+
+    if (state == Uncovered && !isRoot[id]) {
+      isRoot[id] = true;
+      roots.push_back(node);
+    }
+  }
+
+  // post-order of the subtrees (reversed pre-order with the children pushed
+  // in order)
+  std::vector<NodePtr> order;
+  std::vector<NodePtr> stack;
+  for (NodePtr root : roots) {
+    const std::size_t first = order.size();
+    stack.push_back(root);
+    while (!stack.empty()) {
+      NodePtr node = stack.back();
+      stack.pop_back();
+      order.push_back(node);
+      for (NodePtr c : node->children())
+        stack.push_back(c);
+    }
+    std::reverse(order.begin() + first, order.end());
+  }
+
+  std::vector<ContourSet> contours(nodeIds.size());
+  std::vector<ContourSet> partial(tree.numberOfNodes());   // sets not yet consumed by a parent
+  std::vector<uint8> ncount(domain.numberOfPoints());
+
+  for (NodePtr node : order) {
+    ContourSet &Ncontour = partial[node->id()];
+
+    // Take over the largest child's set and merge the smaller ones into it
+    NodePtr largest = nullptr;
+    for (NodePtr c : node->children()) {
+      if (largest == nullptr || partial[c->id()].size() > partial[largest->id()].size())
+        largest = c;
+    }
+
+    if (largest != nullptr) {
+      Ncontour = std::move(partial[largest->id()]);
+      ContourSet().swap(partial[largest->id()]);
+
+      for (NodePtr c : node->children()) {
+        if (c == largest)
+          continue;
+
+        ContourSet &Ccontour = partial[c->id()];
+        Ncontour.insert(Ccontour.begin(), Ccontour.end());
+        ContourSet().swap(Ccontour);
+      }
+    }
+
+    for (uint32 pidx : node->cnps()) {
+      for (uint32 qidx : adj->neighbours(pidx)) {
+        if (qidx == Box::UndefinedIndex || f[pidx] > f[qidx])
+          ncount[pidx]++;
+        else if (f[pidx] < f[qidx]) {
+          ncount[qidx]--;
+
+          if (ncount[qidx] == 0)
+            Ncontour.erase(qidx);
+        }
+      }
+
+      if (ncount[pidx] > 0)
+        Ncontour.insert(pidx);
+    }
+
+    const uint32 i = slot[node->id()];
+    if (i != NotRequested) {
+      if (isRoot[node->id()])
+        contours[i] = std::move(Ncontour);
+      else
+        contours[i] = Ncontour;
+    }
+  }
+
+  // the same node may be requested more than once
+  for (uint32 i = 0; i < nodeIds.size(); i++) {
+    if (slot[nodeIds[i]] != i)
+      contours[i] = contours[slot[nodeIds[i]]];
+  }
+
+  return contours;
+}
+
+template<class ValueType>
+std::vector<morphotree::uint32> nodesInLevelBand(
+  const morphotree::MorphologicalTree<ValueType> &tree,
+  ValueType minLevel, ValueType maxLevel)
+{
+  using NodePtr = typename morphotree::MorphologicalTree<ValueType>::NodePtr;
+
+  std::vector<morphotree::uint32> ids;
+  tree.tranverse([&ids, minLevel, maxLevel](NodePtr node) {
+    if (minLevel <= node->level() && node->level() <= maxLevel)
+      ids.push_back(node->id());
+  });
+
+  return ids;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <morphotree/core/box.hpp>
+#include <morphotree/core/alias.hpp>
+#include <morphotree/adjacency/adjacency.hpp>
+#include <morphotree/tree/mtree.hpp>
+
+#include <vector>
+#include <memory>
+#include <utility>
+
+// Incremental contour extraction with small-to-large merging. Each node takes
+// over the contour set of its largest child by move and inserts only the
+// pixels of the smaller siblings into it, so a pixel is re-inserted at most
+// O(log n) times instead of once per ancestor.
+//
+// A child's set is consumed by its parent. Only nodes flagged in "requested"
+// get a copy of their contour in the returned vector; all other entries are
+// left empty.
+template<class ContourSet, class ValueType>
+std::vector<ContourSet> extractCountorsSmallToLarge(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree,
+  const std::vector<bool> &requested)
+{
+  using MTree = morphotree::MorphologicalTree<ValueType>;
+  using morphotree::uint32;
+  using morphotree::uint8;
+  using morphotree::Box;
+  using NodePtr = typename MTree::NodePtr;
+
+  std::vector<ContourSet> contours(tree.numberOfNodes());
+  std::vector<ContourSet> partial(tree.numberOfNodes());   // sets not yet consumed by a parent
+  std::vector<uint8> ncount(domain.numberOfPoints());
+
+  tree.tranverse([&f, &contours, &partial, &ncount, &requested, adj](NodePtr node){
+    ContourSet &Ncontour = partial[node->id()];
+
+    // Take over the largest child's set and merge the smaller ones into it
+    NodePtr largest = nullptr;
+    for (NodePtr c : node->children()) {
+      if (largest == nullptr || partial[c->id()].size() > partial[largest->id()].size())
+        largest = c;
+    }
+
+    if (largest != nullptr) {
+      Ncontour = std::move(partial[largest->id()]);
+      ContourSet().swap(partial[largest->id()]);
+
+      for (NodePtr c : node->children()) {
+        if (c == largest)
+          continue;
+
+        ContourSet &Ccontour = partial[c->id()];
+        Ncontour.insert(Ccontour.begin(), Ccontour.end());
+        ContourSet().swap(Ccontour);
+      }
+    }
+
+    for (uint32 pidx : node->cnps()) {
+      for (uint32 qidx : adj->neighbours(pidx)) {
+        if (qidx == Box::UndefinedIndex || f[pidx] > f[qidx])
+          ncount[pidx]++;
+        else if (f[pidx] < f[qidx]) {
+          ncount[qidx]--;
+
+          if (ncount[qidx] == 0)
+            Ncontour.erase(qidx);
+        }
+      }
+
+      if (ncount[pidx] > 0)
+        Ncontour.insert(pidx);
+    }
+
+    if (requested[node->id()]) {
+      if (node->parent() == nullptr)
+        contours[node->id()] = std::move(Ncontour);
+      else
+        contours[node->id()] = Ncontour;
+    }
+  });
+
+  return contours;
+}
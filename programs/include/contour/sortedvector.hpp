@@ -0,0 +1,136 @@
+#pragma once
+
+#include <morphotree/core/box.hpp>
+#include <morphotree/core/alias.hpp>
+#include <morphotree/adjacency/adjacency.hpp>
+#include <morphotree/tree/mtree.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Incremental contour extraction with every contour stored as a sorted
+// std::vector of pixel indices. A node first applies the ncount updates of its
+// cnps; its contour is then built by one k-way merge of the children contours
+// and its cnps which are on the contour, dropping the children pixels whose
+// ncount reached 0 in the same pass. The children (and the cnps) are disjoint,
+// so the merge never sees duplicates.
+template<class ValueType>
+std::vector<std::vector<morphotree::uint32>> extractCountorsSortedVector(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree);
+
+// =================== [IMPLEMENTATION] ==========================
+
+// Append to "out" the merge of the sorted "runs" keeping the pixels for
+// which keep(pidx) is true. A linear search of the smallest head is used for
+// a few runs (the common case) and a heap otherwise.
+template<class Predicate>
+void mergeSortedRuns(std::vector<std::pair<const morphotree::uint32*, const morphotree::uint32*>> &runs,
+  std::vector<morphotree::uint32> &out, Predicate keep)
+{
+  using morphotree::uint32;
+  using Run = std::pair<const uint32*, const uint32*>;
+
+  runs.erase(std::remove_if(runs.begin(), runs.end(),
+    [](const Run &r) { return r.first == r.second; }), runs.end());
+
+  if (runs.size() <= 8) {
+    while (!runs.empty()) {
+      std::size_t m = 0;
+      for (std::size_t k = 1; k < runs.size(); k++) {
+        if (*runs[k].first < *runs[m].first)
+          m = k;
+      }
+
+      // copy from the smallest run up to the head of the next smallest one
+      uint32 bound = 0xFFFFFFFF;
+      for (std::size_t k = 0; k < runs.size(); k++) {
+        if (k != m)
+          bound = std::min(bound, *runs[k].first);
+      }
+
+      Run &r = runs[m];
+      while (r.first != r.second && *r.first <= bound) {
+        if (keep(*r.first))
+          out.push_back(*r.first);
+        ++r.first;
+      }
+
+      if (r.first == r.second)
+        runs.erase(runs.begin() + m);
+    }
+    return;
+  }
+
+  auto greater = [](const Run &a, const Run &b) { return *a.first > *b.first; };
+  std::make_heap(runs.begin(), runs.end(), greater);
+  while (!runs.empty()) {
+    std::pop_heap(runs.begin(), runs.end(), greater);
+    Run &r = runs.back();
+    if (keep(*r.first))
+      out.push_back(*r.first);
+
+    if (++r.first == r.second)
+      runs.pop_back();
+    else
+      std::push_heap(runs.begin(), runs.end(), greater);
+  }
+}
+
+template<class ValueType>
+std::vector<std::vector<morphotree::uint32>> extractCountorsSortedVector(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree)
+{
+  using MTree = morphotree::MorphologicalTree<ValueType>;
+  using morphotree::uint32;
+  using morphotree::uint8;
+  using morphotree::Box;
+  using NodePtr = typename MTree::NodePtr;
+  using Run = std::pair<const uint32*, const uint32*>;
+
+  std::vector<std::vector<uint32>> contours(tree.numberOfNodes());
+  std::vector<uint8> ncount(domain.numberOfPoints());
+  std::vector<uint32> inserted;
+  std::vector<Run> runs;
+
+  tree.tranverse([&](NodePtr node){
+
+    // ncount updates of the cnps
+    inserted.clear();
+    for (uint32 pidx : node->cnps()) {
+      for (uint32 qidx : adj->neighbours(pidx)) {
+        if (qidx == Box::UndefinedIndex || f[pidx] > f[qidx])
+          ncount[pidx]++;
+        else if (f[pidx] < f[qidx])
+          ncount[qidx]--;
+      }
+
+      if (ncount[pidx] > 0)
+        inserted.push_back(pidx);
+    }
+    std::sort(inserted.begin(), inserted.end());
+
+    // contour of node "N": merge of the children contours and the new pixels
+    std::size_t bound = inserted.size();
+    runs.clear();
+    runs.emplace_back(inserted.data(), inserted.data() + inserted.size());
+    for (NodePtr c : node->children()) {
+      const std::vector<uint32> &cc = contours[c->id()];
+      runs.emplace_back(cc.data(), cc.data() + cc.size());
+      bound += cc.size();
+    }
+
+    std::vector<uint32> &Ncontour = contours[node->id()];
+    Ncontour.reserve(bound);
+    mergeSortedRuns(runs, Ncontour, [&ncount](uint32 pidx) { return ncount[pidx] > 0; });
+  });
+
+  return contours;
+}
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <morphotree/core/box.hpp>
+#include <morphotree/core/alias.hpp>
+#include <morphotree/tree/mtree.hpp>
+
+#include "contour/workstealing.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Ordered contours of a node computed by contour tracing: the outer contours
+// and the inner (hole) contours as lists of pixels.
+struct TracedContour
+{
+  using Contour = std::vector<morphotree::uint32>;
+
+  std::vector<Contour> Couter;
+  std::vector<Contour> Cinner;
+};
+
+class ContourTracer
+{
+public:
+  using uint8 = morphotree::uint8;
+  using uint32 = morphotree::uint32;
+  using Box = morphotree::Box;
+  using I32Point = morphotree::I32Point;
+  using Contour = TracedContour::Contour;
+
+  using PtDir = std::pair<I32Point, int>;
+
+  ContourTracer(const Box &domain, const std::vector<uint8> &f);
+
+  TracedContour computeContour(const Box &bdomain, uint8 nodeLevel);
+  Contour traceContour(uint8 nodeLevel, const I32Point &xs, int dS, int label);
+  PtDir findNextPoint(uint8 nodeLevel, const I32Point &xc, int d);
+
+  bool bval(uint8 bval, const I32Point &p) const;
+
+private:
+  // The label map L is reset in O(1) per node: an entry is only valid when
+  // its stamp matches the current epoch, otherwise it reads as 0.
+  void nextEpoch();
+  int label(const I32Point &p) const;
+  void setLabel(const I32Point &p, int l);
+
+private:
+  static const std::vector<I32Point> &DELTA();
+
+private:  
+  const std::vector<uint8> &f_;
+  std::vector<int> L_;
+  std::vector<uint32> stamp_;
+  uint32 epoch_;
+  Box Ldomain_;
+  Box domain_;
+};
+
+// Traces the contours of every node, one node after the other.
+std::vector<TracedContour> traceContours(const morphotree::Box &domain,
+  const std::vector<morphotree::uint8> &f, const morphotree::MorphologicalTree<morphotree::uint8> &tree,
+  const std::vector<morphotree::Box> &bb);
+
+// Traces the contours of every node on a pool of threads. Each thread owns a
+// ContourTracer (and so its own label map); the nodes are handed out in
+// descending order of bounding-box area so that the largest ones start first,
+// and every node writes its result into its own preallocated slot.
+std::vector<TracedContour> traceContoursParallel(const morphotree::Box &domain,
+  const std::vector<morphotree::uint8> &f, const morphotree::MorphologicalTree<morphotree::uint8> &tree,
+  const std::vector<morphotree::Box> &bb, WorkStealingPool &pool);
+
+// =================== [IMPLEMENTATION] ==========================
+inline std::vector<TracedContour> traceContours(const morphotree::Box &domain,
+  const std::vector<morphotree::uint8> &f, const morphotree::MorphologicalTree<morphotree::uint8> &tree,
+  const std::vector<morphotree::Box> &bb)
+{
+  using NodePtr = typename morphotree::MorphologicalTree<morphotree::uint8>::NodePtr;
+
+  std::vector<TracedContour> contours(tree.numberOfNodes());
+  ContourTracer ct{domain, f};
+
+  tree.traverseByLevel([&contours, &ct, &bb](NodePtr node){
+    contours[node->id()] = ct.computeContour(bb[node->id()], node->level());
+  });
+
+  return contours;
+}
+
+inline std::vector<TracedContour> traceContoursParallel(const morphotree::Box &domain,
+  const std::vector<morphotree::uint8> &f, const morphotree::MorphologicalTree<morphotree::uint8> &tree,
+  const std::vector<morphotree::Box> &bb, WorkStealingPool &pool)
+{
+  using morphotree::uint32;
+  using NodePtr = typename morphotree::MorphologicalTree<morphotree::uint8>::NodePtr;
+
+  std::vector<TracedContour> contours(tree.numberOfNodes());
+
+  std::vector<NodePtr> nodes;
+  nodes.reserve(tree.numberOfNodes());
+  tree.traverseByLevel([&nodes](NodePtr node) { nodes.push_back(node); });
+  std::stable_sort(nodes.begin(), nodes.end(), [&bb](NodePtr a, NodePtr b) {
+    return bb[a->id()].numberOfPoints() > bb[b->id()].numberOfPoints();
+  });
+
+  // one tracer per worker, plus one for the calling thread (see wait)
+  std::vector<std::unique_ptr<ContourTracer>> tracers(pool.size() + 1);
+  std::atomic<uint32> next{0};
+
+  WorkStealingPool::TaskGroup group;
+  for (unsigned t = 0; t < pool.size(); t++) {
+    pool.submit(group, [&domain, &f, &bb, &pool, &nodes, &contours, &tracers, &next]() {
+      std::unique_ptr<ContourTracer> &ct = tracers[pool.currentWorker()];
+      if (ct == nullptr)
+        ct = std::make_unique<ContourTracer>(domain, f);
+
+      for (uint32 i = next++; i < nodes.size(); i = next++) {
+        NodePtr node = nodes[i];
+        contours[node->id()] = ct->computeContour(bb[node->id()], node->level());
+      }
+    });
+  }
+  pool.wait(group);
+
+  return contours;
+}
+
+inline const std::vector<morphotree::I32Point> &ContourTracer::DELTA()
+{
+  static const std::vector<I32Point> delta = {
+    I32Point{ 1, 0}, I32Point{ 1, 1}, I32Point{ 0, 1}, I32Point{-1, 1},
+    I32Point{-1, 0}, I32Point{-1,-1}, I32Point{ 0,-1}, I32Point{ 1,-1}};
+  return delta;
+}
+  
+inline ContourTracer::ContourTracer(const Box &domain, const std::vector<uint8> &f)
+  :f_{f}, domain_{domain}
+{
+  Ldomain_ = Box::fromCorners(
+    domain.topleft() + I32Point{-1,-1},
+    domain.bottomright() + I32Point{1,1});
+  L_.resize(Ldomain_.numberOfPoints());
+  stamp_.resize(Ldomain_.numberOfPoints(), 0);
+  epoch_ = 0;
+}
+
+inline TracedContour ContourTracer::computeContour(const Box &bdomain, uint8 nodeLevel)
+{
+  using Contour = TracedContour::Contour;
+
+  TracedContour tc;   // create two empty sets of contours
+  nextEpoch();   // create a label map L
+  int R = 0;  // Region counter R
+
+  // Scan the image from left to right and top to bottom
+  I32Point p;
+  for (p.y() = bdomain.top(); p.y() <= bdomain.bottom(); p.y()++) {
+    int l = 0;   // set the current label l to "none"
+    for (p.x() = bdomain.left(); p.x() <= bdomain.right(); p.x()++) {
+      if (bval(nodeLevel, p)) {
+        if (l != 0)  // continue inside region
+          setLabel(p, l); 
+        else {
+          l = label(p);
+          if (l == 0) {   // hit a new outer contour
+            R++;
+            l = R;
+            Contour c = traceContour(nodeLevel, p, 0, l);
+            tc.Couter.push_back(c);      // collect outer contour
+            setLabel(p, l);
+          }
+        }
+      }
+      else {    // background pixel
+        if (l != 0) {
+          if (label(p) == 0) {  // hit new inner contour
+            I32Point xS = p + I32Point{-1, 0};
+            Contour c = traceContour(nodeLevel, xS, 1, l);
+            tc.Cinner.push_back(c);           // collect inner contour
+          }
+          l = 0;
+        }
+      }        
+    }
+  }
+  return tc;
+}
+
+// Contour traceContour(const I32Point &xs, int dS, int label);
+// uint32 findNextPoint(const I32Point &xc, int d);
+
+inline ContourTracer::Contour ContourTracer::traceContour(uint8 nodeLevel,
+  const I32Point &xs, int dS, int label) 
+{
+  PtDir pd = findNextPoint(nodeLevel, xs, dS);
+  I32Point xt = pd.first;
+  int dnext = pd.second;
+
+  Contour c{domain_.pointToIndex(xt)};   // create a contour starting with xT
+  I32Point xp = xs;                      // previous position xp
+  I32Point xc = xt;                      // current position xc
+
+  bool done = xs == xt;                  // isolated pixel?
+
+  while (!done) {
+     setLabel(xc, label);
+    int dsearch = (dnext + 6) % 8;
+    PtDir xn_dnext = findNextPoint(nodeLevel, xc, dsearch);
+    I32Point xn = xn_dnext.first;
+    dnext = xn_dnext.second;
+    
+    xp = xc;
+    xc = xn;
+    done = (xp == xs && xc == xt);   // back at start point?
+    
+    if (!done)
+      c.push_back(domain_.pointToIndex(xn));
+  }
+  return c;
+}
+
+inline ContourTracer::PtDir ContourTracer::findNextPoint(uint8 nodeLevel,
+  const I32Point &xc, int d)
+{
+  PtDir pd;
+  for (int i = 0; i <= 6; i++) {
+    I32Point xprime = xc + DELTA()[d];
+    if (!bval(nodeLevel, xprime)) {
+      setLabel(xprime, -1);
+      d = (d + 1) % 8;
+    }
+    else 
+      return std::make_pair(xprime, d);
+  }
+  return std::make_pair(xc, d);
+}
+
+inline void ContourTracer::nextEpoch()
+{
+  epoch_++;
+  if (epoch_ == 0) {   // stamps wrapped around
+    std::fill(stamp_.begin(), stamp_.end(), 0);
+    epoch_ = 1;
+  }
+}
+
+inline int ContourTracer::label(const I32Point &p) const
+{
+  uint32 pidx = Ldomain_.pointToIndex(p);
+  return stamp_[pidx] == epoch_ ? L_[pidx] : 0;
+}
+
+inline void ContourTracer::setLabel(const I32Point &p, int l)
+{
+  uint32 pidx = Ldomain_.pointToIndex(p);
+  L_[pidx] = l;
+  stamp_[pidx] = epoch_;
+}
+
+inline bool ContourTracer::bval(uint8 bval, const I32Point &p) const 
+{
+  if (domain_.contains(p))
+    return f_[domain_.pointToIndex(p)] >= bval;
+  
+  // p outside domain correspond to background pixel
+  return false;
+}
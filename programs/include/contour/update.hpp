@@ -0,0 +1,183 @@
+#pragma once
+
+#include <morphotree/core/box.hpp>
+#include <morphotree/core/alias.hpp>
+#include <morphotree/adjacency/adjacency.hpp>
+#include <morphotree/tree/mtree.hpp>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Contours of the max-tree "tree" of an image "f" which differs from the
+// previous one (max-tree "previousTree", contours "previousContours") only at
+// the "changed" pixels, e.g. two frames of a video.
+//
+// A node whose pixels and their neighbours are all unchanged is a component of
+// the same upper level set in both images, so it is also a node of the
+// previous tree (the one of any of its cnps) with the same contour: its set is
+// moved out of "previousContours". Only the nodes containing a changed pixel
+// or a neighbour of one (and their ancestors) are computed, with the
+// incremental algorithm; the lower-neighbour counts of the contour pixels of
+// their reused children are rebuilt from the levels of those children.
+//
+// Both trees must have been built with the same adjacency, which must contain
+// the contour adjacency. "previousContours" is consumed.
+template<class ContourSet, class ValueType>
+std::vector<ContourSet> updateContours(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree,
+  const morphotree::MorphologicalTree<ValueType> &previousTree,
+  std::vector<ContourSet> &previousContours,
+  const std::vector<morphotree::uint32> &changed);
+
+// Same, for the pixels of the rectangle "dirty".
+template<class ContourSet, class ValueType>
+std::vector<ContourSet> updateContours(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree,
+  const morphotree::MorphologicalTree<ValueType> &previousTree,
+  std::vector<ContourSet> &previousContours,
+  const morphotree::Box &dirty);
+
+// =================== [IMPLEMENTATION] ==========================
+template<class ContourSet, class ValueType>
+std::vector<ContourSet> updateContours(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree,
+  const morphotree::MorphologicalTree<ValueType> &previousTree,
+  std::vector<ContourSet> &previousContours,
+  const std::vector<morphotree::uint32> &changed)
+{
+  using MTree = morphotree::MorphologicalTree<ValueType>;
+  using morphotree::uint32;
+  using morphotree::int32;
+  using morphotree::uint8;
+  using morphotree::Box;
+  using morphotree::I32Point;
+  using NodePtr = typename MTree::NodePtr;
+
+  std::vector<ContourSet> contours(tree.numberOfNodes());
+  std::vector<uint8> ncount(domain.numberOfPoints());
+
+  // nodes with a changed pixel or a neighbour of one (3x3 window, which
+  // covers 4- and 8-adjacency) in their subtree
+  std::vector<bool> dirty(tree.numberOfNodes(), false);
+  for (uint32 pidx : changed) {
+    const I32Point p = domain.indexToPoint(pidx);
+    for (int32 dy = -1; dy <= 1; dy++) {
+      for (int32 dx = -1; dx <= 1; dx++) {
+        const I32Point q(p.x() + dx, p.y() + dy);
+        if (!domain.contains(q))
+          continue;
+
+        for (NodePtr node = tree.smallComponent(domain.pointToIndex(q));
+             node != nullptr && !dirty[node->id()]; node = node->parent())
+          dirty[node->id()] = true;
+      }
+    }
+  }
+
+  // reuse the contours of a clean subtree
+  std::vector<NodePtr> stack;
+  auto reuse = [&](NodePtr root) {
+    stack.push_back(root);
+    while (!stack.empty()) {
+      NodePtr node = stack.back();
+      stack.pop_back();
+
+      NodePtr previous = previousTree.smallComponent(node->cnps().front());
+      contours[node->id()] = std::move(previousContours[previous->id()]);
+      for (NodePtr c : node->children())
+        stack.push_back(c);
+    }
+
+    // ncount of its contour pixels: neighbours out of the domain or below its level
+    for (uint32 pidx : contours[root->id()]) {
+      for (uint32 qidx : adj->neighbours(pidx)) {
+        if (qidx == Box::UndefinedIndex || f[qidx] < root->level())
+          ncount[pidx]++;
+      }
+    }
+  };
+
+  if (!dirty[tree.root()->id()]) {
+    reuse(tree.root());
+    return contours;
+  }
+
+  // post-order of the dirty nodes
+  std::vector<std::pair<NodePtr, bool>> order = { {tree.root(), false} };
+  while (!order.empty()) {
+    std::pair<NodePtr, bool> top = order.back();
+    order.pop_back();
+
+    NodePtr node = top.first;
+    if (!top.second) {
+      order.emplace_back(node, true);
+      for (NodePtr c : node->children()) {
+        if (dirty[c->id()])
+          order.emplace_back(c, false);
+      }
+      continue;
+    }
+
+    // Initialise contours of node "N"
+    ContourSet &Ncontour = contours[node->id()];
+    for (NodePtr c : node->children()) {
+      if (!dirty[c->id()])
+        reuse(c);
+
+      for (uint32 pidx : contours[c->id()])
+        Ncontour.insert(pidx);
+    }
+
+    for (uint32 pidx : node->cnps()) {
+      for (uint32 qidx : adj->neighbours(pidx)) {
+        if (qidx == Box::UndefinedIndex || f[pidx] > f[qidx])
+          ncount[pidx]++;
+        else if (f[pidx] < f[qidx]) {
+          ncount[qidx]--;
+
+          if (ncount[qidx] == 0)
+            Ncontour.erase(qidx);
+        }
+      }
+
+      if (ncount[pidx] > 0)
+        Ncontour.insert(pidx);
+    }
+  }
+
+  return contours;
+}
+
+template<class ContourSet, class ValueType>
+std::vector<ContourSet> updateContours(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  std::shared_ptr<morphotree::Adjacency> adj,
+  const morphotree::MorphologicalTree<ValueType> &tree,
+  const morphotree::MorphologicalTree<ValueType> &previousTree,
+  std::vector<ContourSet> &previousContours,
+  const morphotree::Box &dirty)
+{
+  using morphotree::I32Point;
+
+  std::vector<morphotree::uint32> changed;
+  I32Point p;
+  for (p.y() = dirty.top(); p.y() <= dirty.bottom(); p.y()++) {
+    for (p.x() = dirty.left(); p.x() <= dirty.right(); p.x()++) {
+      if (domain.contains(p))
+        changed.push_back(domain.pointToIndex(p));
+    }
+  }
+
+  return updateContours(domain, f, adj, tree, previousTree, previousContours, changed);
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Thread pool with one task deque per worker. A worker pops the tasks it
+// submitted itself from the back of its own deque (LIFO) and, when it runs
+// out of work, steals from the front of the other deques (FIFO).
+//
+// Tasks are submitted into a TaskGroup. wait(group) does not block the
+// calling thread: it keeps running (or stealing) tasks until every task of
+// the group has finished, so a task can submit and wait for sub-tasks.
+class WorkStealingPool
+{
+public:
+  using Task = std::function<void()>;
+
+  class TaskGroup
+  {
+  public:
+    TaskGroup() : pending_{0} {}
+
+  private:
+    friend class WorkStealingPool;
+    std::atomic<std::size_t> pending_;
+  };
+
+  explicit WorkStealingPool(unsigned nthreads = std::thread::hardware_concurrency());
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool &) = delete;
+  WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+  unsigned size() const { return static_cast<unsigned>(queues_.size()); }
+
+  void submit(TaskGroup &group, Task task);
+  void wait(TaskGroup &group);
+
+  // Index of the calling thread in this pool, or size() for any other thread.
+  unsigned currentWorker() const;
+
+private:
+  struct Job
+  {
+    Task task;
+    TaskGroup *group;
+  };
+
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<Job> jobs;
+  };
+
+  struct WorkerSlot
+  {
+    const WorkStealingPool *pool;
+    unsigned index;
+  };
+
+  static WorkerSlot &slot();
+
+  void workerLoop(unsigned index);
+  bool tryRun(unsigned self);
+  bool pop(unsigned self, Job &job);
+
+private:
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+  std::atomic<bool> done_;
+  std::atomic<std::size_t> queued_;
+  std::atomic<unsigned> nextQueue_;
+  std::mutex sleepMutex_;
+  std::condition_variable sleepCv_;
+};
+
+// =================== [IMPLEMENTATION] ==========================
+inline WorkStealingPool::WorkStealingPool(unsigned nthreads)
+  : done_{false}, queued_{0}, nextQueue_{0}
+{
+  if (nthreads == 0)
+    nthreads = 1;
+
+  for (unsigned i = 0; i < nthreads; i++)
+    queues_.push_back(std::make_unique<Queue>());
+
+  // the queues are complete before any worker starts
+  threads_.reserve(nthreads);
+  for (unsigned i = 0; i < nthreads; i++)
+    threads_.emplace_back([this, i]() { workerLoop(i); });
+}
+
+inline WorkStealingPool::~WorkStealingPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex_);
+    done_ = true;
+  }
+  sleepCv_.notify_all();
+
+  for (std::thread &t : threads_)
+    t.join();
+}
+
+inline WorkStealingPool::WorkerSlot &WorkStealingPool::slot()
+{
+  static thread_local WorkerSlot s{nullptr, 0};
+  return s;
+}
+
+inline unsigned WorkStealingPool::currentWorker() const
+{
+  const WorkerSlot &s = slot();
+  return s.pool == this ? s.index : size();
+}
+
+inline void WorkStealingPool::submit(TaskGroup &group, Task task)
+{
+  unsigned self = currentWorker();
+  if (self == size())
+    self = nextQueue_++ % size();
+
+  group.pending_++;
+  {
+    std::lock_guard<std::mutex> lock(queues_[self]->mutex);
+    queues_[self]->jobs.push_back(Job{std::move(task), &group});
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex_);
+    queued_++;
+  }
+  sleepCv_.notify_one();
+}
+
+inline void WorkStealingPool::wait(TaskGroup &group)
+{
+  const unsigned self = currentWorker();
+  while (group.pending_ > 0) {
+    if (!tryRun(self))
+      std::this_thread::yield();
+  }
+}
+
+inline void WorkStealingPool::workerLoop(unsigned index)
+{
+  slot() = WorkerSlot{this, index};
+
+  while (!done_) {
+    if (!tryRun(index)) {
+      std::unique_lock<std::mutex> lock(sleepMutex_);
+      sleepCv_.wait_for(lock, std::chrono::milliseconds(1),
+        [this]() { return done_ || queued_ > 0; });
+    }
+  }
+}
+
+inline bool WorkStealingPool::pop(unsigned self, Job &job)
+{
+  const unsigned n = size();
+
+  // own deque first (newest task), then steal the oldest task of the others
+  if (self < n) {
+    Queue &q = *queues_[self];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (!q.jobs.empty()) {
+      job = std::move(q.jobs.back());
+      q.jobs.pop_back();
+      return true;
+    }
+  }
+
+  for (unsigned i = 1; i <= n; i++) {
+    Queue &q = *queues_[(self + i) % n];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (!q.jobs.empty()) {
+      job = std::move(q.jobs.front());
+      q.jobs.pop_front();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+inline bool WorkStealingPool::tryRun(unsigned self)
+{
+  Job job;
+  if (!pop(self, job))
+    return false;
+
+  queued_--;
+  job.task();
+  job.group->pending_--;
+  return true;
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include "contour/padded.hpp"
+
+#include <morphotree/core/box.hpp>
+#include <morphotree/core/alias.hpp>
+#include <morphotree/tree/mtree.hpp>
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Pixel layout in 8x8 tiles: the tiles are stored row by row and the 64
+// pixels of a tile in Z-order (Morton order), so a tile of TiledValue is two
+// cache lines (one for the uint8 lower-neighbour counts) and most
+// 8-neighbourhoods fall into one or two tiles, instead of three rows of a
+// row-major image. The layout covers the domain
+// plus a one pixel border (as PaddedImage), so neighbours are read without
+// bounds checks.
+//
+// The Morton code is the interleave of the bits of x and y, so the tiled
+// index is the sum of a term of the column and a term of the row, both kept
+// in tables: index(x, y) = col_[x+1] + row_[y+1]. (A Hilbert order has no
+// such split, which is why Z-order is used.)
+class TiledLayout
+{
+public:
+  using uint32 = morphotree::uint32;
+  using int32 = morphotree::int32;
+
+  static const uint32 TileSize = 8;
+
+  TiledLayout(const morphotree::Box &domain);
+
+  uint32 size() const { return size_; }
+
+  // Tiled index of the domain pixel (x, y), with -1 <= x <= width and
+  // -1 <= y <= height (the border).
+  uint32 index(int32 x, int32 y) const { return col_[x+1] + row_[y+1]; }
+
+  // Tiled index of the row-major pixel "pidx" of the domain.
+  uint32 toTiled(uint32 pidx) const { return index(pidx % width_, pidx / width_); }
+
+  // Row-major index of the tiled index of a domain pixel.
+  uint32 toRowMajor(uint32 tidx) const { return rowMajor_[tidx]; }
+
+  // Copy of "f" in the tiled layout with "sentinel" on the border and in
+  // the unused pixels of the last tiles.
+  template<class T, class ValueType>
+  std::vector<T> tile(const std::vector<ValueType> &f, T sentinel) const;
+
+private:
+  uint32 width_;
+  uint32 height_;
+  uint32 size_;
+  std::vector<uint32> col_;
+  std::vector<uint32> row_;
+  std::vector<uint32> rowMajor_;
+};
+
+// Grey-level type of a tiled image: 16 bits hold any uint8 grey-level and a
+// sentinel lower than all of them, at a quarter of the size of PaddedValue.
+using TiledValue = std::int16_t;
+static const TiledValue TiledSentinel = -1;
+
+// Incremental contour extraction (same as extractCountorsPadded) with the
+// image, the lower-neighbour counts and the contours in the tiled layout.
+// The grey-levels must fit in [0, 32767] (TiledValue).
+// The cnps of the tree are translated when they are read; the contours hold
+// tiled indices (see TiledLayout::toRowMajor).
+template<class AdjacencyType, class ContourSet, class ValueType>
+std::vector<ContourSet> extractCountorsTiled(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  const morphotree::MorphologicalTree<ValueType> &tree,
+  const TiledLayout &layout);
+
+// Contours of extractCountorsTiled with row-major pixel indices (the
+// translation a caller of the row-major API pays).
+template<class ContourSet>
+std::vector<ContourSet> contoursToRowMajor(const TiledLayout &layout,
+  const std::vector<ContourSet> &tiledContours);
+
+// =================== [IMPLEMENTATION] ==========================
+inline TiledLayout::TiledLayout(const morphotree::Box &domain)
+  : width_{domain.width()}, height_{domain.height()},
+    col_(domain.width() + 2), row_(domain.height() + 2)
+{
+  // bits 0, 2, 4 of the Morton code of a tile for x and 1, 3, 5 for y
+  auto spread = [](uint32 v) { return (v & 1) | ((v & 2) << 1) | ((v & 4) << 2); };
+
+  const uint32 tilesPerRow = (width_ + 2 + TileSize - 1) / TileSize;
+  const uint32 tilesPerColumn = (height_ + 2 + TileSize - 1) / TileSize;
+  const uint32 tileArea = TileSize * TileSize;
+  size_ = tilesPerRow * tilesPerColumn * tileArea;
+
+  for (uint32 x = 0; x < col_.size(); x++)
+    col_[x] = (x / TileSize) * tileArea + spread(x % TileSize);
+
+  for (uint32 y = 0; y < row_.size(); y++)
+    row_[y] = (y / TileSize) * tilesPerRow * tileArea + (spread(y % TileSize) << 1);
+
+  rowMajor_.resize(size_, morphotree::Box::UndefinedIndex);
+  for (uint32 pidx = 0; pidx < width_ * height_; pidx++)
+    rowMajor_[toTiled(pidx)] = pidx;
+}
+
+template<class T, class ValueType>
+std::vector<T> TiledLayout::tile(const std::vector<ValueType> &f, T sentinel) const
+{
+  std::vector<T> tiled(size_, sentinel);
+  for (uint32 pidx = 0; pidx < width_ * height_; pidx++)
+    tiled[toTiled(pidx)] = static_cast<T>(f[pidx]);
+
+  return tiled;
+}
+
+template<class AdjacencyType, class ContourSet, class ValueType>
+std::vector<ContourSet> extractCountorsTiled(
+  const morphotree::Box &domain,
+  const std::vector<ValueType> &f,
+  const morphotree::MorphologicalTree<ValueType> &tree,
+  const TiledLayout &layout)
+{
+  using MTree = morphotree::MorphologicalTree<ValueType>;
+  using morphotree::uint32;
+  using morphotree::int32;
+  using morphotree::uint8;
+  using NodePtr = typename MTree::NodePtr;
+  using Offsets = AdjacencyOffsets<AdjacencyType>;
+
+  static_assert(std::numeric_limits<ValueType>::is_integer 
+    && std::numeric_limits<ValueType>::min() >= 0
+    && std::numeric_limits<ValueType>::max() <= std::numeric_limits<TiledValue>::max(),
+    "the grey-levels of a tiled image must fit in TiledValue");
+
+  const std::vector<TiledValue> ftiled = layout.tile(f, TiledSentinel);
+  const uint32 width = domain.width();
+
+  std::vector<ContourSet> contours(tree.numberOfNodes());
+  std::vector<uint8> ncount(layout.size());
+
+  tree.tranverse([&](NodePtr node){
+
+    // Initialise contours of node "N"
+    ContourSet &Ncontour = contours[node->id()];
+    for (NodePtr c : node->children()) {
+      for (uint32 tidx : contours[c->id()])
+        Ncontour.insert(tidx);
+    }
+
+    for (uint32 pidx : node->cnps()) {
+      const int32 x = pidx % width, y = pidx / width;
+      const uint32 tidx = layout.index(x, y);
+      const TiledValue fp = ftiled[tidx];
+
+      for (int k = 0; k < Offsets::Size; k++) {
+        const uint32 qidx = layout.index(x + Offsets::dx(k), y + Offsets::dy(k));
+        const TiledValue fq = ftiled[qidx];
+        if (fp > fq)
+          ncount[tidx]++;
+        else if (fp < fq) {
+          ncount[qidx]--;
+
+          if (ncount[qidx] == 0)
+            Ncontour.erase(qidx);
+        }
+      }
+
+      if (ncount[tidx] > 0)
+        Ncontour.insert(tidx);
+    }
+  });
+
+  return contours;
+}
+
+template<class ContourSet>
+std::vector<ContourSet> contoursToRowMajor(const TiledLayout &layout,
+  const std::vector<ContourSet> &tiledContours)
+{
+  std::vector<ContourSet> contours(tiledContours.size());
+  for (std::size_t id = 0; id < tiledContours.size(); id++) {
+    contours[id].reserve(tiledContours[id].size());
+    for (morphotree::uint32 tidx : tiledContours[id])
+      contours[id].insert(layout.toRowMajor(tidx));
+  }
+
+  return contours;
+}
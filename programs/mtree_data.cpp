@@ -1,3 +1,5 @@
+#include "contour/counts.hpp"
+
 #include <iostream>
 
 #include <morphotree/adjacency/adjacency4c.hpp>
@@ -122,21 +124,28 @@ void inputImage(const std::string &filepath)
   std::shared_ptr<Adjacency> adj = std::make_shared<Adjacency4C>(domain);
   MTree tree = buildMaxTree(f, adj);
 
-  std::vector<std::unordered_set<uint32>> contours =
-    extractCountors(domain, f, std::make_shared<InfAdjacency4C>(domain), tree);
+  // only the sizes are needed, so the contours are counted, not stored
+  ContourCounts counts = 
+    computeContourCounts(domain, f, std::make_shared<InfAdjacency4C>(domain), tree);
 
   unsigned long sumContour = 0;
   unsigned long maxContour = 0;
   unsigned long sumChildren = 0;
   unsigned long maxChildren = 0;
+  unsigned long sumEdges = 0;
+  unsigned long maxEdges = 0;
 
   tree.tranverse([&](NodePtr node){
     sumChildren += node->children().size();
-    sumContour += contours[node->id()].size();
+    sumContour += counts.pixels[node->id()];
+    sumEdges += counts.edges[node->id()];
 
-    if (maxContour < contours[node->id()].size())
-      maxContour = contours[node->id()].size();
+    if (maxContour < counts.pixels[node->id()])
+      maxContour = counts.pixels[node->id()];
     
+    if (maxEdges < counts.edges[node->id()])
+      maxEdges = counts.edges[node->id()];
+
     if (maxChildren < node->children().size())
       maxChildren = node->children().size();
   });  
@@ -145,5 +154,7 @@ void inputImage(const std::string &filepath)
             << "sum_children= " << sumChildren << "\n"
             << "max_children= " << maxChildren << "\n"
             << "sum_contour= " << sumContour << "\n"
-            << "max_contour= " << maxContour << "\n"; 
+            << "max_contour= " << maxContour << "\n"
+            << "sum_edges= " << sumEdges << "\n"
+            << "max_edges= " << maxEdges << "\n"; 
 }
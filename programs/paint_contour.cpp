@@ -1,3 +1,5 @@
+#include "contour/contourindex.hpp"
+
 #include <morphotree/core/box.hpp>
 #include <morphotree/attributes/countorExtraction.hpp>
 
@@ -120,7 +122,6 @@ int main(int argc, char *argv[])
   using morphotree::I32Point;
   using morphotree::AreaComputer;
 
-  using morphotree::extractCountors;
   using morphotree::reconstructContourImage;
 
   // ====================================================
@@ -179,10 +180,6 @@ int main(int argc, char *argv[])
   }
 
 
-  std::vector<std::unordered_set<uint32>> contours = 
-    extractCountors(domain, f, std::make_shared<InfAdjacency4C>(domain), tree);
-
-
   int maxChildren = 0;
   uint32 nodeId = 0;
 
@@ -220,6 +217,9 @@ int main(int argc, char *argv[])
 
   std::cout << "\n" << nodeId << " : " << maxChildren << "\n";
 
+  // only a few nodes are painted: their contours are read from the implicit index
+  ContourIndex<uint8> contours(domain, f, std::make_shared<InfAdjacency4C>(domain), tree);
+
   NodePtr node = tree.node(nodeId);
   int cmIdx = 0;                            // colour map index
   for (NodePtr c : selectedNodes) {
@@ -228,12 +228,12 @@ int main(int argc, char *argv[])
     float hue = (static_cast<float>(cmIdx) / static_cast<float>(maxChildren)) * 360.0f; // hue in degrees
     Color color = HSVtoRGB(hue, SATURATION, VALUE);   // Convert to RGB
 
-    for (uint32 pidx : contours[c->id()]) {
+    contours.forEachPixel(c->id(), [&outputContour, &color](uint32 pidx) {
       uint32 cidx = pidx * 3;
       outputContour[cidx] = color.r;
       outputContour[cidx+1] = color.g;
       outputContour[cidx+2] = color.b;
-    }
+    });
 
     for (uint32 pidx : c->reconstruct()) {
       uint32 cidx = pidx * 3;
@@ -0,0 +1,99 @@
+#include "contour/incremental.hpp"
+#include "contour/filter.hpp"
+
+#include <iostream>
+
+#include <morphotree/adjacency/adjacency4c.hpp>
+#include <morphotree/attributes/areaComputer.hpp>
+#include <morphotree/tree/ct_builder.hpp>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <unordered_set>
+
+namespace mt = morphotree;
+
+int main(int argc, char *argv[])
+{
+  using mt::uint8;
+  using mt::uint32;
+  using MTree = mt::MorphologicalTree<uint8>;
+  using NodePtr = typename MTree::NodePtr;
+  using mt::InfAdjacency4C;
+  using mt::Adjacency4C;
+  using mt::Adjacency;
+  using mt::Box;
+  using mt::UI32Point;
+  using mt::AreaComputer;
+  using mt::buildMaxTree;
+  using ContourSet = std::unordered_set<uint32>;
+
+  using std::chrono::high_resolution_clock;
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+
+  if (argc > 1) {
+    int nx, ny, nc;
+    uint8 *data = stbi_load(argv[1], &nx, &ny, &nc, 0);
+
+    std::vector<uint8> f(data, data + (nx*ny));
+    Box domain = Box::fromSize(UI32Point{
+      static_cast<uint32>(nx), static_cast<uint32>(ny)});
+
+    // ----------------------------------------------------------------------------
+    // OPTIONS
+    //   -a <a1> <a2> ...  increasing area thresholds of the sweep (default:
+    //                     10 50 100 500 1000 5000).
+    // ----------------------------------------------------------------------------
+    std::vector<uint32> thresholds;
+    for (int i = 2; i < argc; i++) {
+      std::string option{ argv[i] };
+      if (option == "-a") {
+        while (i + 1 < argc && argv[i+1][0] != '-')
+          thresholds.push_back(std::atoi(argv[++i]));
+      }
+    }
+    if (thresholds.empty())
+      thresholds = { 10, 50, 100, 500, 1000, 5000 };
+
+    std::shared_ptr<Adjacency> adj = std::make_shared<Adjacency4C>(domain);
+    std::shared_ptr<Adjacency> cadj = std::make_shared<InfAdjacency4C>(domain);
+
+    // the filtered tree of every threshold is filtered again by the next one
+    MTree tree = buildMaxTree(f, adj);
+    MTree reusedTree = buildMaxTree(f, adj);
+    std::vector<uint32> area = std::make_unique<AreaComputer<uint8>>()->computeAttribute(tree);
+    std::vector<ContourSet> contours = 
+      extractCountorsIncremental<ContourSet>(domain, f, cadj, reusedTree);
+
+    for (uint32 threshold : thresholds) {
+      auto keep = [&area, threshold](NodePtr node) { return area[node->id()] > threshold; };
+
+      auto start = high_resolution_clock::now();
+      tree.idirectFilter(keep);
+      std::vector<ContourSet> recomputed = 
+        extractCountorsIncremental<ContourSet>(domain, f, cadj, tree);
+      auto end = high_resolution_clock::now();
+      auto recomputeTime = duration_cast<microseconds>(end - start).count();
+
+      start = high_resolution_clock::now();
+      contours = idirectFilterContours<ContourSet, uint8>(reusedTree, contours, keep);
+      end = high_resolution_clock::now();
+      auto reuseTime = duration_cast<microseconds>(end - start).count();
+
+      std::cout << "area > " << threshold << ": " << tree.numberOfNodes() << " nodes, "
+                << "recomputed (us): " << recomputeTime << ", reused (us): " << reuseTime << "\n";
+
+      // a kept node has the same pixels after filtering: only its id changed
+      area = std::make_unique<AreaComputer<uint8>>()->computeAttribute(tree);
+    }
+  }
+  else {
+    std::cerr << "Error, it needs to receive a path for a image file";
+  }
+
+  return 0;
+}
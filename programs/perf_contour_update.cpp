@@ -0,0 +1,96 @@
+#include "contour/incremental.hpp"
+#include "contour/update.hpp"
+
+#include <iostream>
+
+#include <morphotree/adjacency/adjacency4c.hpp>
+#include <morphotree/tree/ct_builder.hpp>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <unordered_set>
+
+namespace mt = morphotree;
+
+int main(int argc, char *argv[])
+{
+  using mt::uint8;
+  using mt::uint32;
+  using mt::int32;
+  using MTree = mt::MorphologicalTree<uint8>;
+  using mt::InfAdjacency4C;
+  using mt::Adjacency4C;
+  using mt::Adjacency;
+  using mt::Box;
+  using mt::UI32Point;
+  using mt::I32Point;
+  using mt::buildMaxTree;
+
+  using std::chrono::high_resolution_clock;
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+
+  if (argc > 1) {
+    int nx, ny, nc;
+    uint8 *data = stbi_load(argv[1], &nx, &ny, &nc, 0);
+
+    std::vector<uint8> f(data, data + (nx*ny));
+    Box domain = Box::fromSize(UI32Point{
+      static_cast<uint32>(nx), static_cast<uint32>(ny)});
+
+    // ----------------------------------------------------------------------------
+    // OPTIONS
+    //   -r <x> <y> <w> <h>  rectangle changed in the next frame (default: a 
+    //                       16x16 square at the centre of the image).
+    // ----------------------------------------------------------------------------
+    int32 x = nx/2 - 8, y = ny/2 - 8, w = 16, h = 16;
+    for (int i = 2; i < argc; i++) {
+      std::string option{ argv[i] };
+      if (option == "-r" && i + 4 < argc) {
+        x = std::atoi(argv[++i]);
+        y = std::atoi(argv[++i]);
+        w = std::atoi(argv[++i]);
+        h = std::atoi(argv[++i]);
+      }
+    }
+    Box dirty = Box::fromCorners(I32Point{x, y}, I32Point{x + w - 1, y + h - 1});
+
+    std::shared_ptr<Adjacency> adj = std::make_shared<Adjacency4C>(domain);
+    std::shared_ptr<Adjacency> cadj = std::make_shared<InfAdjacency4C>(domain);
+    MTree previousTree = buildMaxTree(f, adj);
+    std::vector<std::unordered_set<uint32>> previousContours = 
+      extractCountorsIncremental<std::unordered_set<uint32>>(domain, f, cadj, previousTree);
+
+    // next frame: the rectangle is inverted
+    I32Point p;
+    for (p.y() = dirty.top(); p.y() <= dirty.bottom(); p.y()++) {
+      for (p.x() = dirty.left(); p.x() <= dirty.right(); p.x()++) {
+        if (domain.contains(p))
+          f[domain.pointToIndex(p)] = 255 - f[domain.pointToIndex(p)];
+      }
+    }
+    MTree tree = buildMaxTree(f, adj);
+
+    auto start = high_resolution_clock::now();
+    std::vector<std::unordered_set<uint32>> contours = 
+      extractCountorsIncremental<std::unordered_set<uint32>>(domain, f, cadj, tree);
+    auto end = high_resolution_clock::now();
+    std::cout << "full extraction time elapsed (us): " 
+              << duration_cast<microseconds>(end - start).count() << "\n";
+
+    start = high_resolution_clock::now();
+    std::vector<std::unordered_set<uint32>> updated = updateContours(domain, f, cadj, tree, 
+      previousTree, previousContours, dirty);
+    end = high_resolution_clock::now();
+    std::cout << "update time elapsed (us): " 
+              << duration_cast<microseconds>(end - start).count() << "\n";
+  }
+  else {
+    std::cerr << "Error, it needs to receive a path for a image file";
+  }
+
+  return 0;
+}
@@ -0,0 +1,78 @@
+#include "contour/bitmap.hpp"
+
+#include <iostream>
+
+#include <morphotree/adjacency/adjacency4c.hpp>
+#include <morphotree/adjacency/adjacency8c.hpp>
+#include <morphotree/tree/ct_builder.hpp>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <chrono>
+
+namespace mt = morphotree;
+
+int main(int argc, char *argv[])
+{
+  using mt::uint8;
+  using mt::uint32;
+  using MTree = mt::MorphologicalTree<uint8>;
+  using mt::InfAdjacency4C;
+  using mt::InfAdjacency8C;
+  using mt::Adjacency4C;
+  using mt::Adjacency;
+  using mt::Box;
+  using mt::UI32Point;
+  using mt::buildMaxTree;
+
+  using std::chrono::high_resolution_clock;
+  using std::chrono::duration_cast;
+  using std::chrono::milliseconds;
+
+  if (argc > 1) {
+    int nx, ny, nc;
+    uint8 *data = stbi_load(argv[1], &nx, &ny, &nc, 0);
+
+    std::vector<uint8> f(data, data + (nx*ny));
+    Box domain = Box::fromSize(UI32Point{
+      static_cast<uint32>(nx), static_cast<uint32>(ny)});
+
+    std::shared_ptr<Adjacency> adj = std::make_shared<Adjacency4C>(domain);
+    MTree tree = buildMaxTree(f, adj);
+
+    // ----------------------------------------------------------------------------
+    // OPTIONS
+    //   -c 4|8  contour adjacency (default: 4).
+    // ----------------------------------------------------------------------------
+    bool contour8C = false;
+    for (int i = 2; i < argc; i++) {
+      std::string option{ argv[i] };
+      if (option == "-c" && i + 1 < argc)
+        contour8C = argv[++i][0] == '8';
+    }
+
+    std::shared_ptr<Adjacency> cadj;
+    if (contour8C)
+      cadj = std::make_shared<InfAdjacency8C>(domain);
+    else
+      cadj = std::make_shared<InfAdjacency4C>(domain);
+
+    auto start = high_resolution_clock::now();
+    std::vector<BitmapContour> contours = extractCountorsBitmap(domain, f, cadj, tree);
+    auto end = high_resolution_clock::now();
+
+    auto timeElapsed = duration_cast<milliseconds>(end - start);
+    std::cout << "time elapsed: " << timeElapsed.count() << "\n";
+
+    std::size_t bytes = 0;
+    for (const BitmapContour &c : contours)
+      bytes += c.memory();
+    std::cout << "bitmap memory (bytes): " << bytes << "\n";
+  }
+  else {
+    std::cerr << "Error, it needs to receive a path for a image file";
+  }
+
+  return 0;
+}
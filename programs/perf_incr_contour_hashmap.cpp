@@ -1,6 +1,14 @@
+#include "contour/incremental.hpp"
+#include "contour/smalltolarge.hpp"
+#include "contour/padded.hpp"
+#include "contour/zorder.hpp"
+#include "contour/ncount.hpp"
+#include "contour/parallel.hpp"
+
 #include <iostream>
 
 #include <morphotree/adjacency/adjacency4c.hpp>
+#include <morphotree/adjacency/adjacency8c.hpp>
 #include <morphotree/tree/ct_builder.hpp>
 
 #include <morphotree/core/io.hpp>
@@ -12,6 +20,9 @@
 #include <stb_image_write.h>
 
 #include <chrono>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
 
 
 #include <morphotree/adjacency/adjacency.hpp>
@@ -22,63 +33,10 @@
 
 namespace mt = morphotree;
 
-template<class ValueType>
-std::vector<std::unordered_set<mt::uint32>> extractCountorsHashMap(
-  const mt::Box &domain,
-  const std::vector<ValueType> &f,
-  std::shared_ptr<mt::Adjacency> adj,
-  const mt::MorphologicalTree<ValueType> &tree);
-
 std::vector<bool> reconstructContourImage(const std::unordered_set<mt::uint32>& contour, 
   const mt::Box &domain);
 
 // =================== [IMPLEMENTATION] ==========================
-template<class ValueType>
-std::vector<std::unordered_set<mt::uint32>> extractCountorsHashMap(
-  const mt::Box &domain, 
-  const std::vector<ValueType> &f,
-  std::shared_ptr<mt::Adjacency> adj,
-  const mt::MorphologicalTree<ValueType> &tree)
-{
-  using MTree = mt::MorphologicalTree<ValueType>;
-  using mt::uint32;
-  using mt::uint8;
-  using mt::Box;
-  using NodePtr = typename MTree::NodePtr;
-
-  std::vector<std::unordered_set<uint32>> contours(tree.numberOfNodes());
-  std::vector<uint8> ncount(domain.numberOfPoints());
-
-  tree.tranverse([&f, &contours, &ncount, adj](NodePtr node){
-    
-    // Initialise contours of node "N"
-    std::unordered_set<uint32> &Ncontour = contours[node->id()];
-    for (NodePtr c : node->children()) {
-      for (uint32 pidx : contours[c->id()])
-        Ncontour.insert(pidx);
-    }
-
-    for (uint32 pidx : node->cnps()) {
-      for (uint32 qidx : adj->neighbours(pidx)) {
-        if (qidx == Box::UndefinedIndex || f[pidx] > f[qidx]) 
-          ncount[pidx]++;
-        else if (f[pidx] < f[qidx]) {
-          ncount[qidx]--;
-
-          if (ncount[qidx] == 0) 
-            Ncontour.erase(qidx);
-        }
-      }
-
-      if (ncount[pidx] > 0)
-        Ncontour.insert(pidx);
-    }
-  });
-  
-  return contours;
-}
-
-
 std::vector<bool> reconstructContourImage(const std::unordered_set<mt::uint32>& contour, 
     const mt::Box &domain)
 {
@@ -97,6 +55,7 @@ int main(int argc, char *argv[])
   using MTree = mt::MorphologicalTree<uint8>;
   using NodePtr = typename MTree::NodePtr;
   using mt::InfAdjacency4C;
+  using mt::InfAdjacency8C;
   using mt::Adjacency4C;
   using mt::Adjacency;
   using mt::Box;
@@ -121,14 +80,159 @@ int main(int argc, char *argv[])
     std::shared_ptr<Adjacency> adj = std::make_shared<Adjacency4C>(domain);
     MTree tree = buildMaxTree(f, adj);
 
+    // ----------------------------------------------------------------------------
+    // OPTIONS
+    //   -s      small-to-large merging. Only the contours of the nodes given
+    //           with -n are kept (the root by default), so the sets of the
+    //           other nodes are moved into their parents; a second run which
+    //           keeps every contour (copied before its set is consumed by the
+    //           parent) is timed and shown separately.
+    //   -n <id>[,<id>...]
+    //           with -s, ids of the nodes whose contours are kept.
+    //   -p      compile-time specialised kernel over a padded image.
+    //   -z      same kernel with the pixels in Z-ordered 8x8 tiles.
+    //   -v      lower-neighbour counts precomputed by a vectorised pass (with
+    //           the -p kernel, so the pass is measured by comparing with -p).
+    //   -t <n>  subtree-parallel extraction on a work-stealing pool of n threads.
+    //   -w <k>  with -t, nodes with more than k children merge them with a
+    //           parallel reduction.
+    //   -c 4|8  contour adjacency (default: 4).
+    // ----------------------------------------------------------------------------
+    bool smallToLarge = false;
+    std::vector<uint32> nodeIds;
+    bool padded = false;
+    bool tiled = false;
+    bool precomputed = false;
+    bool contour8C = false;
+    unsigned nthreads = 0;
+    uint32 wideThreshold = std::numeric_limits<uint32>::max();
+    bool wide = false;
+    for (int i = 2; i < argc; i++) {
+      std::string option{ argv[i] };
+      if (option == "-s")
+        smallToLarge = true;
+      else if (option == "-n" && i + 1 < argc) {
+        std::stringstream ids{ argv[++i] };
+        std::string id;
+        while (std::getline(ids, id, ','))
+          nodeIds.push_back(std::atoi(id.c_str()));
+      }
+      else if (option == "-p")
+        padded = true;
+      else if (option == "-z")
+        tiled = true;
+      else if (option == "-v")
+        precomputed = true;
+      else if (option == "-c" && i + 1 < argc)
+        contour8C = argv[++i][0] == '8';
+      else if (option == "-t" && i + 1 < argc)
+        nthreads = std::atoi(argv[++i]);
+      else if (option == "-w" && i + 1 < argc) {
+        wideThreshold = std::atoi(argv[++i]);
+        wide = true;
+      }
+    }
+
+    if (smallToLarge && (padded || tiled || precomputed || nthreads > 0)) {
+      std::cerr << "Error: -s cannot be combined with -p, -z, -v or -t\n";
+      return -1;
+    }
+
+    if (!nodeIds.empty() && !smallToLarge) {
+      std::cerr << "Error: -n can only be used with -s\n";
+      return -1;
+    }
+
+    for (uint32 id : nodeIds) {
+      if (id >= tree.numberOfNodes()) {
+        std::cerr << "Error: node " << id << " is not in the tree\n";
+        return -1;
+      }
+    }
+
+    // each of these selects a different kernel
+    if (padded + tiled + precomputed + (nthreads > 0) > 1) {
+      std::cerr << "Error: only one of -p, -z, -v and -t can be given\n";
+      return -1;
+    }
+
+    if (wide && nthreads == 0) {
+      std::cerr << "Error: -w can only be used with -t\n";
+      return -1;
+    }
+
+    // the tree is 4-connected: with 8-connected contours the decrements of a
+    // subtree reach pixels of its siblings, which other threads are processing
+    if (nthreads > 0 && contour8C) {
+      std::cerr << "Error: -t cannot be used with -c 8 (the tree is 4-connected)\n";
+      return -1;
+    }
+
+    std::shared_ptr<Adjacency> cadj;
+    if (contour8C)
+      cadj = std::make_shared<InfAdjacency8C>(domain);
+    else
+      cadj = std::make_shared<InfAdjacency4C>(domain);
+
+    std::unique_ptr<WorkStealingPool> pool;
+    if (nthreads > 0)
+      pool = std::make_unique<WorkStealingPool>(nthreads);
+
+    // the layout tables only depend on the image size
+    std::unique_ptr<TiledLayout> layout;
+    if (tiled)
+      layout = std::make_unique<TiledLayout>(domain);
+
     auto start = high_resolution_clock::now();
-    std::vector<std::unordered_set<uint32>> contours = 
-      extractCountorsHashMap(domain, f, std::make_shared<InfAdjacency4C>(domain),
-      tree);
+    std::vector<std::unordered_set<uint32>> contours;
+    if (smallToLarge) {
+      // only the requested contours are copied, the other sets are consumed
+      std::vector<bool> requested(tree.numberOfNodes(), false);
+      if (nodeIds.empty())
+        requested[tree.root()->id()] = true;
+      for (uint32 id : nodeIds)
+        requested[id] = true;
+
+      contours = extractCountorsSmallToLarge<std::unordered_set<uint32>>(domain, f, cadj, 
+        tree, requested);
+    }
+    else if (pool != nullptr)
+      contours = extractCountorsParallel<std::unordered_set<uint32>>(domain, f, cadj, tree, *pool, 
+        wideThreshold);
+    else if (precomputed && contour8C)
+      contours = extractCountorsPrecomputed<InfAdjacency8C, std::unordered_set<uint32>>(domain, f, tree);
+    else if (precomputed)
+      contours = extractCountorsPrecomputed<InfAdjacency4C, std::unordered_set<uint32>>(domain, f, tree);
+    else if (tiled && contour8C)
+      contours = contoursToRowMajor(*layout, 
+        extractCountorsTiled<InfAdjacency8C, std::unordered_set<uint32>>(domain, f, tree, *layout));
+    else if (tiled)
+      contours = contoursToRowMajor(*layout, 
+        extractCountorsTiled<InfAdjacency4C, std::unordered_set<uint32>>(domain, f, tree, *layout));
+    else if (padded && contour8C) 
+      contours = extractCountorsPadded<InfAdjacency8C, std::unordered_set<uint32>>(domain, f, tree);
+    else if (padded)
+      contours = extractCountorsPadded<InfAdjacency4C, std::unordered_set<uint32>>(domain, f, tree);
+    else 
+      contours = extractCountorsIncremental<std::unordered_set<uint32>>(domain, f, cadj, tree);
     auto end = high_resolution_clock::now();
 
     auto timeElapsed = duration_cast<milliseconds>(end - start);
     std::cout << "time elapsed: " << timeElapsed.count() << "\n";
+
+    if (smallToLarge) {
+      contours.clear();
+
+      // the same merging with every contour kept
+      std::vector<bool> requested(tree.numberOfNodes(), true);
+      start = high_resolution_clock::now();
+      contours = extractCountorsSmallToLarge<std::unordered_set<uint32>>(domain, f, cadj, 
+        tree, requested);
+      end = high_resolution_clock::now();
+
+      timeElapsed = duration_cast<milliseconds>(end - start);
+      std::cout << "time elapsed (every contour kept): " << timeElapsed.count() << "\n";
+    }
   }
   else {
     std::cerr << "Error, it needs to receive a path for a image file";
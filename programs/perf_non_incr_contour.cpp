@@ -1,7 +1,11 @@
+#include "contour/padded.hpp"
+#include "contour/nonincremental.hpp"
+
 #include <iostream>
 
 #include <morphotree/attributes/countorExtraction.hpp>
 #include <morphotree/adjacency/adjacency4c.hpp>
+#include <morphotree/adjacency/adjacency8c.hpp>
 #include <morphotree/tree/ct_builder.hpp>
 #include <morphotree/attributes/boundingboxComputer.hpp>
 
@@ -14,6 +18,7 @@
 #include <stb_image_write.h>
 
 #include <chrono>
+#include <cstdlib>
 
 namespace mt = morphotree;
 
@@ -26,8 +31,8 @@ int main(int argc, char *argv[])
   using mt::uint8;
   using mt::uint32;
   using MTree = mt::MorphologicalTree<uint8>;
-  using NodePtr = typename MTree::NodePtr;
   using mt::InfAdjacency4C;
+  using mt::InfAdjacency8C;
   using mt::Adjacency4C;
   using mt::Adjacency;
   using mt::Box;
@@ -55,28 +60,59 @@ int main(int argc, char *argv[])
     std::shared_ptr<Adjacency> adj = std::make_shared<Adjacency4C>(domain);
     MTree tree = buildMaxTree(f, adj);
 
+    // ----------------------------------------------------------------------------
+    // OPTIONS
+    //   -p      compile-time specialised kernel over a padded image.
+    //   -t <n>  multithreaded extraction on a pool of n threads, with per-thread
+    //           pixel buffers and output arenas (uses the padded kernel).
+    //   -c 4|8  contour adjacency (default: 4).
+    // ----------------------------------------------------------------------------
+    bool padded = false;
+    bool contour8C = false;
+    unsigned nthreads = 0;
+    for (int i = 2; i < argc; i++) {
+      std::string option{ argv[i] };
+      if (option == "-p")
+        padded = true;
+      else if (option == "-c" && i + 1 < argc)
+        contour8C = argv[++i][0] == '8';
+      else if (option == "-t" && i + 1 < argc)
+        nthreads = std::atoi(argv[++i]);
+    }
+
+    if (padded && nthreads > 0) {
+      std::cerr << "Error: only one of -p and -t can be given\n";
+      return -1;
+    }
+
+    std::unique_ptr<WorkStealingPool> pool;
+    if (nthreads > 0)
+      pool = std::make_unique<WorkStealingPool>(nthreads);
+
     auto start = high_resolution_clock::now();
     
     // ----------------------------------------------------------------------------
     // NON-INCREMENTAL CONTOURS COMPUTATION
     // ----------------------------------------------------------------------------
-    std::vector<std::unordered_set<uint32>> contours(tree.numberOfNodes());
-    std::unique_ptr<Adjacency> cadj = std::make_unique<InfAdjacency4C>(domain);
-
-    tree.traverseByLevel([&contours, &domain, &cadj, &f](NodePtr node){
-      std::vector<uint32> bnode = node->reconstruct();
-      std::unordered_set<uint32> Ncountor;
-      for (uint32 pidx : bnode) {
-        for (uint32 qidx : cadj->neighbours(pidx)) {
-          I32Point q = domain.indexToPoint(qidx);
-          if(!domain.contains(q) || f[qidx] < node->level()) {
-            Ncountor.insert(pidx);
-          }
-        }
-      }
-
-      contours[node->id()] = Ncountor;
-    });
+    std::vector<std::unordered_set<uint32>> contours;
+    ContourArena arena;
+    if (pool != nullptr && contour8C)
+      arena = extractCountorsNonIncrementalParallel<InfAdjacency8C>(domain, f, tree, *pool);
+    else if (pool != nullptr)
+      arena = extractCountorsNonIncrementalParallel<InfAdjacency4C>(domain, f, tree, *pool);
+    else if (padded && contour8C)
+      contours = extractCountorsNonIncrementalPadded<InfAdjacency8C>(domain, f, tree);
+    else if (padded)
+      contours = extractCountorsNonIncrementalPadded<InfAdjacency4C>(domain, f, tree);
+    else {
+      std::shared_ptr<Adjacency> cadj;
+      if (contour8C)
+        cadj = std::make_shared<InfAdjacency8C>(domain);
+      else
+        cadj = std::make_shared<InfAdjacency4C>(domain);
+
+      contours = extractCountorsNonIncremental(domain, f, cadj, tree);
+    }
 
     auto end = high_resolution_clock::now();
 